@@ -0,0 +1,118 @@
+#include "DescriptorAllocator.hpp"
+
+#include <stdexcept>
+
+DescriptorAllocator::DescriptorAllocator(uint32_t persistent_count, uint32_t per_frame_count, uint32_t frame_count)
+    : _persistent_count(persistent_count),
+    _per_frame_count(per_frame_count),
+    _frame_count(frame_count),
+    _allocated(persistent_count, false),
+    _pending_frees(frame_count),
+    _frame_index(0),
+    _frame_head(0)
+{
+    if (frame_count == 0)
+    {
+        throw std::invalid_argument("DescriptorAllocator: at least one frame is required");
+    }
+    if (static_cast<uint64_t>(persistent_count) + static_cast<uint64_t>(per_frame_count) * frame_count > UINT32_MAX)
+    {
+        throw std::invalid_argument("DescriptorAllocator: too many descriptors");
+    }
+
+    _free_slots.reserve(persistent_count);
+    for (uint32_t n = persistent_count; n > 0; n--)
+    {
+        _free_slots.push_back(n - 1);
+    }
+}
+
+uint32_t DescriptorAllocator::allocate_persistent()
+{
+    if (_free_slots.empty())
+    {
+        throw std::length_error("DescriptorAllocator: no persistent descriptors left");
+    }
+
+    const uint32_t index = _free_slots.back();
+    _free_slots.pop_back();
+    _allocated[index] = true;
+    return index;
+}
+
+void DescriptorAllocator::free_persistent(uint32_t index)
+{
+    if (index >= _persistent_count)
+    {
+        throw std::out_of_range("DescriptorAllocator: not a persistent descriptor");
+    }
+    if (!_allocated[index])
+    {
+        throw std::logic_error("DescriptorAllocator: descriptor freed twice");
+    }
+
+    _allocated[index] = false;
+    _pending_frees[_frame_index].push_back(index);
+}
+
+bool DescriptorAllocator::is_allocated(uint32_t index) const
+{
+    return index < _persistent_count && _allocated[index];
+}
+
+void DescriptorAllocator::begin_frame(uint32_t frame_index)
+{
+    if (frame_index >= _frame_count)
+    {
+        throw std::out_of_range("DescriptorAllocator: frame index out of range");
+    }
+
+    _frame_index = frame_index;
+    _frame_head = 0;
+
+    std::vector<uint32_t>& pending = _pending_frees[frame_index];
+    _free_slots.insert(_free_slots.end(), pending.begin(), pending.end());
+    pending.clear();
+}
+
+uint32_t DescriptorAllocator::allocate_frame(uint32_t count)
+{
+    if (count > _per_frame_count - _frame_head)
+    {
+        throw std::length_error("DescriptorAllocator: frame descriptors exhausted");
+    }
+
+    const uint32_t index = _persistent_count + _frame_index * _per_frame_count + _frame_head;
+    _frame_head += count;
+    return index;
+}
+
+uint32_t DescriptorAllocator::get_capacity() const
+{
+    return _persistent_count + _per_frame_count * _frame_count;
+}
+
+uint32_t DescriptorAllocator::get_persistent_count() const
+{
+    return _persistent_count;
+}
+
+uint32_t DescriptorAllocator::get_per_frame_count() const
+{
+    return _per_frame_count;
+}
+
+uint32_t DescriptorAllocator::get_frame_count() const
+{
+    return _frame_count;
+}
+
+uint32_t DescriptorAllocator::get_persistent_used() const
+{
+    return _persistent_count - static_cast<uint32_t>(_free_slots.size());
+}
+
+uint32_t DescriptorAllocator::get_frame_used() const
+{
+    return _frame_head;
+}
\ No newline at end of file
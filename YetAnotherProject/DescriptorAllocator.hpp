@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Slot bookkeeping for one descriptor heap, without any api calls. The heap is split into two regions:
+// - persistent slots [0, persistent_count) are handed out and returned one by one through a free list,
+//   for descriptors that live as long as their resource. A freed slot may still be read by frames in
+//   flight, it is only reused after begin_frame comes back to the frame slot it was freed in.
+// - the rest is a ring with one linear region of per_frame_count slots per frame in flight, for tables
+//   that are only needed by the frame that builds them. A region is reset as a whole by begin_frame, once
+//   the gpu finished the frame that used it last (see FrameFence).
+// Not thread safe.
+class DescriptorAllocator
+{
+public:
+    DescriptorAllocator(uint32_t persistent_count, uint32_t per_frame_count, uint32_t frame_count);
+
+    // throws std::length_error if all persistent slots are in use
+    uint32_t allocate_persistent();
+    // Deferred, see above. Throws std::out_of_range for indices outside the persistent region and
+    // std::logic_error on double frees.
+    void free_persistent(uint32_t index);
+    // false for slots that are freed but not yet reusable
+    bool is_allocated(uint32_t index) const;
+
+    // Call once the frame slot is free again (its fence passed). Resets the region of frame_index and
+    // returns the persistent slots freed during its last use to the free list.
+    void begin_frame(uint32_t frame_index);
+    // First index of count contiguous slots in the region of the current frame, e.g. a descriptor table.
+    // Throws std::length_error if the region is exhausted.
+    uint32_t allocate_frame(uint32_t count);
+
+    // total number of slots, the size of the heap
+    uint32_t get_capacity() const;
+    uint32_t get_persistent_count() const;
+    uint32_t get_per_frame_count() const;
+    uint32_t get_frame_count() const;
+    // includes freed slots that are not yet reusable
+    uint32_t get_persistent_used() const;
+    uint32_t get_frame_used() const;
+
+private:
+    uint32_t _persistent_count;
+    uint32_t _per_frame_count;
+    uint32_t _frame_count;
+
+    // popped from the back, initially in ascending order so the lowest slots are used first
+    std::vector<uint32_t> _free_slots;
+    std::vector<bool> _allocated;
+    // slots freed while recording each frame slot
+    std::vector<std::vector<uint32_t> > _pending_frees;
+
+    uint32_t _frame_index;
+    uint32_t _frame_head;
+};
\ No newline at end of file
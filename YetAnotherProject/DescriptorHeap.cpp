@@ -0,0 +1,97 @@
+#include "DescriptorHeap.hpp"
+
+#include <stdexcept>
+
+#include "d3d12_helper.hpp"
+
+DescriptorHeap::DescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t persistent_count, uint32_t per_frame_count, uint32_t frame_count)
+    : _device(device),
+    _type(type),
+    _increment_size(device->GetDescriptorHandleIncrementSize(type)),
+    _allocator(persistent_count, per_frame_count, frame_count)
+{
+    _heap = create_descriptor_heap(device, _allocator.get_capacity(), type, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+    NAME_D3D12_OBJECT(_heap);
+
+    // only persistent descriptors are staged, frame tables are copied together from them
+    if (persistent_count > 0)
+    {
+        _staging_heap = create_descriptor_heap(device, persistent_count, type);
+        NAME_D3D12_OBJECT(_staging_heap);
+    }
+}
+
+uint32_t DescriptorHeap::allocate()
+{
+    return _allocator.allocate_persistent();
+}
+
+void DescriptorHeap::free(uint32_t index)
+{
+    _allocator.free_persistent(index);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::get_staging_handle(uint32_t index) const
+{
+    if (index >= _allocator.get_persistent_count())
+    {
+        throw std::out_of_range("DescriptorHeap: not a persistent descriptor");
+    }
+
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE(_staging_heap->GetCPUDescriptorHandleForHeapStart(), index, _increment_size);
+}
+
+void DescriptorHeap::commit(uint32_t index)
+{
+    if (!_allocator.is_allocated(index))
+    {
+        throw std::logic_error("DescriptorHeap: commit of a descriptor that is not allocated");
+    }
+
+    _device->CopyDescriptorsSimple(1, get_cpu_handle(index), get_staging_handle(index), _type);
+}
+
+void DescriptorHeap::begin_frame(uint32_t frame_index)
+{
+    _allocator.begin_frame(frame_index);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorHeap::stage_table(std::span<const uint32_t> indices)
+{
+    // validate everything first, a throw must not leave a half copied table behind
+    for (const uint32_t index : indices)
+    {
+        if (!_allocator.is_allocated(index))
+        {
+            throw std::logic_error("DescriptorHeap: table references a descriptor that is not allocated");
+        }
+    }
+
+    const uint32_t first = _allocator.allocate_frame(static_cast<uint32_t>(indices.size()));
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        _device->CopyDescriptorsSimple(1, get_cpu_handle(first + static_cast<uint32_t>(i)), get_staging_handle(indices[i]), _type);
+    }
+
+    return get_gpu_handle(first);
+}
+
+ID3D12DescriptorHeap* DescriptorHeap::get_heap() const
+{
+    return _heap.Get();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::get_cpu_handle(uint32_t index) const
+{
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE(_heap->GetCPUDescriptorHandleForHeapStart(), index, _increment_size);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorHeap::get_gpu_handle(uint32_t index) const
+{
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE(_heap->GetGPUDescriptorHandleForHeapStart(), index, _increment_size);
+}
+
+const DescriptorAllocator& DescriptorHeap::get_allocator() const
+{
+    return _allocator;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+// Windows Runtime Library. Needed for Microsoft::WRL::ComPtr<> template class.
+#include <wrl.h>
+using namespace Microsoft::WRL;
+#include <d3d12.h>
+
+#include "DescriptorAllocator.hpp"
+
+// One shader visible heap for all descriptors of a type (cbv/srv/uav or sampler), so command lists set it
+// once instead of switching heaps per object. Descriptors are written into a cpu only staging heap, which
+// is cheap to read for copies, and copied into the shader visible heap from there:
+// - allocate() a persistent slot, create the view at get_staging_handle(index) and commit(index) it
+// - free() keeps the slot reserved until the frames that may still read it have finished
+// - stage_table() copies persistent descriptors into a contiguous table of the current frame
+class DescriptorHeap
+{
+public:
+    DescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t persistent_count, uint32_t per_frame_count, uint32_t frame_count);
+
+    DescriptorHeap(const DescriptorHeap&) = delete;
+    DescriptorHeap& operator = (const DescriptorHeap&) = delete;
+
+    uint32_t allocate();
+    // The slot is reused once begin_frame is called for the current frame slot again, i.e. once every
+    // frame recorded until now has finished on the gpu. Throws std::logic_error if index isn't allocated.
+    void free(uint32_t index);
+    // where the view of a persistent slot has to be created, throws std::out_of_range for other indices
+    D3D12_CPU_DESCRIPTOR_HANDLE get_staging_handle(uint32_t index) const;
+    // Copies the staged descriptor of index into the shader visible heap. Fresh slots are never read by the gpu,
+    // re-committing a slot that frames in flight still use is up to the caller.
+    void commit(uint32_t index);
+
+    // Call once the frame slot is free again (its fence passed), releases the slots freed during its last use.
+    void begin_frame(uint32_t frame_index);
+    // Copies the staged descriptors into a table of the current frame and returns its start for SetGraphicsRootDescriptorTable.
+    D3D12_GPU_DESCRIPTOR_HANDLE stage_table(std::span<const uint32_t> indices);
+
+    ID3D12DescriptorHeap* get_heap() const;
+    D3D12_CPU_DESCRIPTOR_HANDLE get_cpu_handle(uint32_t index) const;
+    D3D12_GPU_DESCRIPTOR_HANDLE get_gpu_handle(uint32_t index) const;
+    const DescriptorAllocator& get_allocator() const;
+
+private:
+    ID3D12Device* _device;
+    D3D12_DESCRIPTOR_HEAP_TYPE _type;
+    UINT _increment_size;
+    ComPtr<ID3D12DescriptorHeap> _heap;
+    ComPtr<ID3D12DescriptorHeap> _staging_heap;
+    DescriptorAllocator _allocator;
+};
\ No newline at end of file
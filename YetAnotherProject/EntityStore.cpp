@@ -0,0 +1,239 @@
+#include "EntityStore.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+template <typename Op>
+void EntityStore::for_each_array(Op op)
+{
+    op(_entities);
+    op(_position_x); op(_position_y); op(_position_z);
+    op(_orientation);
+    op(_scale_x); op(_scale_y); op(_scale_z);
+    op(_local_center_x); op(_local_center_y); op(_local_center_z);
+    op(_local_extent_x); op(_local_extent_y); op(_local_extent_z);
+    op(_draw_calls);
+    op(_world_matrices);
+    op(_world_center_x); op(_world_center_y); op(_world_center_z);
+    op(_world_extent_x); op(_world_extent_y); op(_world_extent_z);
+}
+
+Entity EntityStore::create()
+{
+    uint32_t index;
+    if (!_free_indices.empty())
+    {
+        index = _free_indices.back();
+        _free_indices.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(_dense_indices.size());
+        _dense_indices.push_back(invalid_dense_index);
+        _generations.push_back(0);
+    }
+
+    const Entity entity = { index, _generations[index] };
+    _dense_indices[index] = static_cast<uint32_t>(_entities.size());
+
+    _entities.push_back(entity);
+    _position_x.push_back(0.0f); _position_y.push_back(0.0f); _position_z.push_back(0.0f);
+    _orientation.push_back(quat::identity());
+    _scale_x.push_back(1.0f); _scale_y.push_back(1.0f); _scale_z.push_back(1.0f);
+    _local_center_x.push_back(0.0f); _local_center_y.push_back(0.0f); _local_center_z.push_back(0.0f);
+    _local_extent_x.push_back(0.0f); _local_extent_y.push_back(0.0f); _local_extent_z.push_back(0.0f);
+    _draw_calls.push_back({ 0, 0, 0 });
+    _world_matrices.push_back(mat::identity());
+    _world_center_x.push_back(0.0f); _world_center_y.push_back(0.0f); _world_center_z.push_back(0.0f);
+    _world_extent_x.push_back(0.0f); _world_extent_y.push_back(0.0f); _world_extent_z.push_back(0.0f);
+
+    return entity;
+}
+
+void EntityStore::destroy(Entity entity)
+{
+    const uint32_t dense_index = checked_dense_index(entity);
+    const uint32_t last = static_cast<uint32_t>(_entities.size() - 1);
+
+    // keep the dense arrays packed, the last entity takes the place of the destroyed one
+    for_each_array([dense_index, last](auto& array)
+    {
+        array[dense_index] = array[last];
+        array.pop_back();
+    });
+
+    if (dense_index != last)
+    {
+        _dense_indices[_entities[dense_index].index] = dense_index;
+    }
+
+    _dense_indices[entity.index] = invalid_dense_index;
+    _generations[entity.index]++;
+    _free_indices.push_back(entity.index);
+}
+
+bool EntityStore::is_alive(Entity entity) const
+{
+    return get_dense_index(entity) != invalid_dense_index;
+}
+
+void EntityStore::clear()
+{
+    for (const Entity& entity : _entities)
+    {
+        _dense_indices[entity.index] = invalid_dense_index;
+        _generations[entity.index]++;
+        _free_indices.push_back(entity.index);
+    }
+
+    for_each_array([](auto& array) { array.clear(); });
+}
+
+void EntityStore::reserve(std::size_t count)
+{
+    for_each_array([count](auto& array) { array.reserve(count); });
+}
+
+std::size_t EntityStore::size() const
+{
+    return _entities.size();
+}
+
+uint32_t EntityStore::get_dense_index(Entity entity) const
+{
+    if (entity.index >= _dense_indices.size() || _generations[entity.index] != entity.generation)
+    {
+        return invalid_dense_index;
+    }
+
+    return _dense_indices[entity.index];
+}
+
+uint32_t EntityStore::checked_dense_index(Entity entity) const
+{
+    const uint32_t dense_index = get_dense_index(entity);
+    if (dense_index == invalid_dense_index)
+    {
+        throw std::invalid_argument("EntityStore: entity is not alive");
+    }
+
+    return dense_index;
+}
+
+void EntityStore::set_position(Entity entity, const vec3f& position)
+{
+    const uint32_t i = checked_dense_index(entity);
+    _position_x[i] = position.x;
+    _position_y[i] = position.y;
+    _position_z[i] = position.z;
+}
+
+vec3f EntityStore::get_position(Entity entity) const
+{
+    const uint32_t i = checked_dense_index(entity);
+    return vec3f(_position_x[i], _position_y[i], _position_z[i]);
+}
+
+void EntityStore::set_orientation(Entity entity, const quatf& orientation)
+{
+    _orientation[checked_dense_index(entity)] = orientation;
+}
+
+quatf EntityStore::get_orientation(Entity entity) const
+{
+    return _orientation[checked_dense_index(entity)];
+}
+
+void EntityStore::set_scale(Entity entity, const vec3f& scale)
+{
+    const uint32_t i = checked_dense_index(entity);
+    _scale_x[i] = scale.x;
+    _scale_y[i] = scale.y;
+    _scale_z[i] = scale.z;
+}
+
+vec3f EntityStore::get_scale(Entity entity) const
+{
+    const uint32_t i = checked_dense_index(entity);
+    return vec3f(_scale_x[i], _scale_y[i], _scale_z[i]);
+}
+
+void EntityStore::set_local_bounds(Entity entity, const vec3f& center, const vec3f& extent)
+{
+    const uint32_t i = checked_dense_index(entity);
+    _local_center_x[i] = center.x;
+    _local_center_y[i] = center.y;
+    _local_center_z[i] = center.z;
+    _local_extent_x[i] = extent.x;
+    _local_extent_y[i] = extent.y;
+    _local_extent_z[i] = extent.z;
+}
+
+void EntityStore::set_draw_call(Entity entity, const RenderBackend::DrawCall& draw_call)
+{
+    _draw_calls[checked_dense_index(entity)] = draw_call;
+}
+
+std::span<const Entity> EntityStore::get_entities() const
+{
+    return _entities;
+}
+
+EntityStore::Transforms EntityStore::get_transforms()
+{
+    return { _position_x, _position_y, _position_z, _orientation, _scale_x, _scale_y, _scale_z };
+}
+
+std::span<const RenderBackend::DrawCall> EntityStore::get_draw_calls() const
+{
+    return _draw_calls;
+}
+
+std::span<const mat4f> EntityStore::get_world_matrices() const
+{
+    return _world_matrices;
+}
+
+cull::aabb_soa EntityStore::get_world_bounds() const
+{
+    return { _world_center_x, _world_center_y, _world_center_z, _world_extent_x, _world_extent_y, _world_extent_z };
+}
+
+void EntityStore::update_world(std::size_t first, std::size_t last)
+{
+    if (first > last || last > _entities.size())
+    {
+        throw std::out_of_range("EntityStore: update range out of bounds");
+    }
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        // translate * rotate * scale, the scale is folded into the rotation columns
+        mat4f world = mat::rotate(_orientation[i]);
+        const float scale[3] = { _scale_x[i], _scale_y[i], _scale_z[i] };
+        const float position[3] = { _position_x[i], _position_y[i], _position_z[i] };
+        for (int r = 0; r < 3; ++r)
+        {
+            world[r][0] *= scale[0];
+            world[r][1] *= scale[1];
+            world[r][2] *= scale[2];
+            world[r][3] = position[r];
+        }
+        _world_matrices[i] = world;
+
+        // the box around a transformed box: the center is transformed, the extent projected on the world axes
+        const float cx = _local_center_x[i], cy = _local_center_y[i], cz = _local_center_z[i];
+        const float ex = _local_extent_x[i], ey = _local_extent_y[i], ez = _local_extent_z[i];
+        _world_center_x[i] = world[0][0] * cx + world[0][1] * cy + world[0][2] * cz + world[0][3];
+        _world_center_y[i] = world[1][0] * cx + world[1][1] * cy + world[1][2] * cz + world[1][3];
+        _world_center_z[i] = world[2][0] * cx + world[2][1] * cy + world[2][2] * cz + world[2][3];
+        _world_extent_x[i] = std::fabs(world[0][0]) * ex + std::fabs(world[0][1]) * ey + std::fabs(world[0][2]) * ez;
+        _world_extent_y[i] = std::fabs(world[1][0]) * ex + std::fabs(world[1][1]) * ey + std::fabs(world[1][2]) * ez;
+        _world_extent_z[i] = std::fabs(world[2][0]) * ex + std::fabs(world[2][1]) * ey + std::fabs(world[2][2]) * ez;
+    }
+}
+
+void EntityStore::update_world()
+{
+    update_world(0, _entities.size());
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "frustum.hpp"
+#include "mat4.hpp"
+#include "quat.hpp"
+#include "RenderBackend.hpp"
+#include "vec.hpp"
+
+// Generational handle, stays invalid after its entity was destroyed even if the slot is reused.
+struct Entity
+{
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator == (const Entity&) const = default;
+};
+
+// Entities with a transform, local bounds and a draw call, stored as a sparse set: handles map to a dense
+// index and every component lives in its own tightly packed array (structure of arrays). Systems iterate
+// the dense arrays linearly, e.g. update_world over [first, last) from several threads, and the world
+// bounds can be passed to the batched culling as they are. Destroying an entity moves the last dense
+// entry into its place, so dense indices are only stable until the next destroy.
+class EntityStore
+{
+public:
+    static const uint32_t invalid_dense_index = UINT32_MAX;
+
+    // mutable views over the dense components, all spans have size() entries
+    struct Transforms
+    {
+        std::span<float> position_x, position_y, position_z;
+        std::span<quatf> orientation;
+        std::span<float> scale_x, scale_y, scale_z;
+    };
+
+    // identity transform, empty bounds at the origin and no draw call (vertex_count 0)
+    Entity create();
+    // throws std::invalid_argument for dead handles
+    void destroy(Entity entity);
+    bool is_alive(Entity entity) const;
+    void clear();
+    void reserve(std::size_t count);
+
+    std::size_t size() const;
+    // invalid_dense_index for dead handles
+    uint32_t get_dense_index(Entity entity) const;
+
+    // single entity access, throws std::invalid_argument for dead handles
+    void set_position(Entity entity, const vec3f& position);
+    vec3f get_position(Entity entity) const;
+    void set_orientation(Entity entity, const quatf& orientation);
+    quatf get_orientation(Entity entity) const;
+    void set_scale(Entity entity, const vec3f& scale);
+    vec3f get_scale(Entity entity) const;
+    // axis aligned box in model space
+    void set_local_bounds(Entity entity, const vec3f& center, const vec3f& extent);
+    void set_draw_call(Entity entity, const RenderBackend::DrawCall& draw_call);
+
+    // dense arrays, indexed by dense index
+    std::span<const Entity> get_entities() const;
+    Transforms get_transforms();
+    std::span<const RenderBackend::DrawCall> get_draw_calls() const;
+    std::span<const mat4f> get_world_matrices() const;
+    // world space boxes enclosing the transformed local bounds, as of the last update_world
+    cull::aabb_soa get_world_bounds() const;
+
+    // Recomputes world matrices and bounds of the dense range [first, last). Disjoint ranges may be
+    // updated in parallel.
+    void update_world(std::size_t first, std::size_t last);
+    void update_world();
+
+private:
+    // sparse part, indexed by Entity::index
+    std::vector<uint32_t> _dense_indices;
+    std::vector<uint32_t> _generations;
+    std::vector<uint32_t> _free_indices;
+
+    // dense part
+    std::vector<Entity> _entities;
+    std::vector<float> _position_x, _position_y, _position_z;
+    std::vector<quatf> _orientation;
+    std::vector<float> _scale_x, _scale_y, _scale_z;
+    std::vector<float> _local_center_x, _local_center_y, _local_center_z;
+    std::vector<float> _local_extent_x, _local_extent_y, _local_extent_z;
+    std::vector<RenderBackend::DrawCall> _draw_calls;
+    std::vector<mat4f> _world_matrices;
+    std::vector<float> _world_center_x, _world_center_y, _world_center_z;
+    std::vector<float> _world_extent_x, _world_extent_y, _world_extent_z;
+
+    uint32_t checked_dense_index(Entity entity) const;
+
+    // applies op to every dense component array
+    template <typename Op>
+    void for_each_array(Op op);
+};
\ No newline at end of file
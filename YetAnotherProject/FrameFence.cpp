@@ -0,0 +1,87 @@
+#include "FrameFence.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+FrameFence::FrameFence(Timeline& timeline, uint32_t frame_count, uint32_t first_frame_index)
+    : _timeline(timeline),
+    _fence_values(frame_count, 0),
+    _frame_index(first_frame_index),
+    _last_wait_seconds(0.0)
+{
+    if (frame_count < min_frames_in_flight || frame_count > max_frames_in_flight)
+    {
+        throw std::invalid_argument("FrameFence: frames in flight must be between 2 and 4");
+    }
+    if (first_frame_index >= frame_count)
+    {
+        throw std::invalid_argument("FrameFence: first frame index out of range");
+    }
+
+    // the timeline starts at 0, so the first frame signals 1
+    _fence_values[_frame_index] = 1;
+}
+
+uint32_t FrameFence::get_frame_count() const
+{
+    return static_cast<uint32_t>(_fence_values.size());
+}
+
+uint32_t FrameFence::get_frame_index() const
+{
+    return _frame_index;
+}
+
+void FrameFence::advance(uint32_t next_frame_index)
+{
+    if (next_frame_index >= _fence_values.size())
+    {
+        throw std::out_of_range("FrameFence: frame index out of range");
+    }
+
+    // Schedule a Signal command in the queue.
+    const uint64_t current_fence_value = _fence_values[_frame_index];
+    _timeline.signal(current_fence_value);
+
+    _frame_index = next_frame_index;
+
+    // If the next frame is not ready to be rendered yet, wait until it is ready.
+    _last_wait_seconds = 0.0;
+    if (_timeline.get_completed_value() < _fence_values[_frame_index])
+    {
+        const auto start = std::chrono::steady_clock::now();
+        _timeline.wait_for(_fence_values[_frame_index]);
+        _last_wait_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    _wait_stats.add_sample(_last_wait_seconds);
+
+    // Set the fence value for the next frame.
+    _fence_values[_frame_index] = current_fence_value + 1;
+}
+
+void FrameFence::advance()
+{
+    advance((_frame_index + 1) % get_frame_count());
+}
+
+void FrameFence::wait_for_idle()
+{
+    _timeline.signal(_fence_values[_frame_index]);
+    _timeline.wait_for(_fence_values[_frame_index]);
+    _fence_values[_frame_index]++;
+}
+
+double FrameFence::get_last_wait_seconds() const
+{
+    return _last_wait_seconds;
+}
+
+const FrameStats& FrameFence::get_wait_stats() const
+{
+    return _wait_stats;
+}
+
+FrameStats& FrameFence::get_wait_stats()
+{
+    return _wait_stats;
+}
\ No newline at end of file
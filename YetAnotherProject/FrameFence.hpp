@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "FrameStats.hpp"
+
+// Bookkeeping for a ring of frames in flight. Every slot remembers the fence value its last frame
+// signals, before a slot is reused the cpu waits until the gpu reached that value. The gpu side is
+// abstracted as a Timeline, so the ring can be driven by a simulated gpu as well.
+class FrameFence
+{
+public:
+    static const uint32_t min_frames_in_flight = 2;
+    static const uint32_t max_frames_in_flight = 4;
+
+    // A monotonically increasing gpu timeline, e.g. a d3d12 fence signaled on the command queue.
+    class Timeline
+    {
+    public:
+        virtual ~Timeline() = default;
+        // enqueues a signal after all submitted work
+        virtual void signal(uint64_t value) = 0;
+        virtual uint64_t get_completed_value() const = 0;
+        // blocks until the completed value reaches value
+        virtual void wait_for(uint64_t value) = 0;
+    };
+
+    // throws std::invalid_argument unless min_frames_in_flight <= frame_count <= max_frames_in_flight
+    FrameFence(Timeline& timeline, uint32_t frame_count, uint32_t first_frame_index = 0);
+
+    uint32_t get_frame_count() const;
+    uint32_t get_frame_index() const;
+
+    // Call after submitting the current frame. Signals its end and moves to next_frame_index (e.g. the
+    // next back buffer of a swap chain), waiting until the gpu finished the frame that used it before.
+    void advance(uint32_t next_frame_index);
+    // round robin
+    void advance();
+    // waits until the gpu finished everything submitted so far
+    void wait_for_idle();
+
+    // time the cpu spent blocked in the last advance
+    double get_last_wait_seconds() const;
+    // cpu wait of every advance, how much the frames in flight are (not) hiding the gpu latency
+    const FrameStats& get_wait_stats() const;
+    FrameStats& get_wait_stats();
+
+private:
+    Timeline& _timeline;
+    std::vector<uint64_t> _fence_values;
+    uint32_t _frame_index;
+    double _last_wait_seconds;
+    FrameStats _wait_stats;
+};
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "FramePacer.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+FramePacer::SleepFunction FramePacer::thread_sleep()
+{
+    return [](double seconds) { std::this_thread::sleep_for(std::chrono::duration<double>(seconds)); };
+}
+
+FramePacer::SpinFunction FramePacer::thread_spin()
+{
+    return [](double) { std::this_thread::yield(); };
+}
+
+FramePacer::FramePacer()
+    : FramePacer(StepTimer::steady_clock_source(), thread_sleep(), thread_spin())
+{
+}
+
+FramePacer::FramePacer(StepTimer::ClockSource clock_source, SleepFunction sleep, SpinFunction spin)
+    : _clock(std::move(clock_source)),
+    _sleep(std::move(sleep)),
+    _spin(std::move(spin)),
+    _target_frame_rate(0.0),
+    _target_interval(0),
+    _spin_threshold(0),
+    _next_deadline(0),
+    _has_deadline(false),
+    _last_frame_end(0),
+    _has_last_frame(false),
+    _sleep_ticks(0),
+    _spin_ticks(0)
+{
+    set_spin_threshold_seconds(0.002);
+}
+
+void FramePacer::set_target_frame_rate(double frames_per_second)
+{
+    if (!std::isfinite(frames_per_second) || frames_per_second < 0.0)
+    {
+        throw std::invalid_argument("FramePacer: frame rate must be finite and not negative");
+    }
+
+    _target_frame_rate = frames_per_second;
+    _target_interval = frames_per_second > 0.0 ? to_ticks(1.0 / frames_per_second) : 0;
+    // restart the schedule from the next frame
+    _has_deadline = false;
+}
+
+double FramePacer::get_target_frame_rate() const
+{
+    return _target_frame_rate;
+}
+
+bool FramePacer::is_capped() const
+{
+    return _target_interval != 0;
+}
+
+void FramePacer::set_spin_threshold_seconds(double seconds)
+{
+    if (!std::isfinite(seconds) || seconds < 0.0)
+    {
+        throw std::invalid_argument("FramePacer: spin threshold must be finite and not negative");
+    }
+
+    _spin_threshold = to_ticks(seconds);
+}
+
+double FramePacer::get_spin_threshold_seconds() const
+{
+    return to_seconds(_spin_threshold);
+}
+
+void FramePacer::wait_for_next_frame()
+{
+    uint64_t now = _clock.now();
+
+    if (is_capped())
+    {
+        // Deadlines advance by the exact interval, so late wake ups don't add up. After a long hitch
+        // (more than a whole interval late) the schedule restarts instead of rushing to catch up.
+        if (!_has_deadline || now > _next_deadline + _target_interval)
+        {
+            _next_deadline = now;
+            _has_deadline = true;
+        }
+
+        if (now < _next_deadline && _next_deadline - now > _spin_threshold)
+        {
+            _sleep(to_seconds(_next_deadline - now - _spin_threshold));
+            const uint64_t after_sleep = _clock.now();
+            _sleep_ticks += after_sleep - now;
+            now = after_sleep;
+        }
+
+        const uint64_t spin_start = now;
+        while (now < _next_deadline)
+        {
+            const double remaining = to_seconds(_next_deadline - now);
+            if (_spin)
+                _spin(remaining);
+            else
+                _sleep(remaining);
+            now = _clock.now();
+        }
+        (_spin ? _spin_ticks : _sleep_ticks) += now - spin_start;
+
+        _next_deadline += _target_interval;
+    }
+
+    if (_has_last_frame)
+    {
+        const uint64_t interval = now - _last_frame_end;
+        _interval_stats.add_sample(to_seconds(interval));
+        if (is_capped())
+        {
+            const uint64_t error = interval > _target_interval ? interval - _target_interval : _target_interval - interval;
+            _jitter_stats.add_sample(to_seconds(error));
+        }
+    }
+
+    _last_frame_end = now;
+    _has_last_frame = true;
+}
+
+const FrameStats& FramePacer::get_interval_stats() const
+{
+    return _interval_stats;
+}
+
+const FrameStats& FramePacer::get_jitter_stats() const
+{
+    return _jitter_stats;
+}
+
+double FramePacer::get_total_sleep_seconds() const
+{
+    return to_seconds(_sleep_ticks);
+}
+
+double FramePacer::get_total_spin_seconds() const
+{
+    return to_seconds(_spin_ticks);
+}
+
+void FramePacer::reset_stats()
+{
+    _interval_stats.reset();
+    _jitter_stats.reset();
+    _sleep_ticks = 0;
+    _spin_ticks = 0;
+    _has_last_frame = false;
+}
+
+double FramePacer::to_seconds(uint64_t ticks) const
+{
+    return static_cast<double>(ticks) / static_cast<double>(_clock.frequency);
+}
+
+uint64_t FramePacer::to_ticks(double seconds) const
+{
+    return static_cast<uint64_t>(std::llround(seconds * static_cast<double>(_clock.frequency)));
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "FrameStats.hpp"
+#include "StepTimer.hpp"
+
+// Limits the frame rate of the main loop without a swap chain. Uncapped by default, with a target rate
+// every frame waits for its deadline: it sleeps while the deadline is further away than the spin
+// threshold (sleep is cheap but wakes up late) and spins for the rest (exact but burns the core).
+class FramePacer
+{
+public:
+    // Suspends the thread for about the given duration, may wake up later. Replaceable for tests
+    // that advance a manual clock instead.
+    using SleepFunction = std::function<void(double seconds)>;
+    // Called repeatedly until the deadline is reached, with the remaining time, should return quickly.
+    using SpinFunction = std::function<void(double remaining_seconds)>;
+
+    static SleepFunction thread_sleep();
+    // yields the thread
+    static SpinFunction thread_spin();
+
+    FramePacer();
+    // Without a spin function the remainder below the spin threshold is handed to sleep as well, so a
+    // manual clock advanced by sleep reaches every deadline.
+    FramePacer(StepTimer::ClockSource clock_source, SleepFunction sleep = thread_sleep(), SpinFunction spin = SpinFunction());
+
+    // 0 disables the cap, throws std::invalid_argument for negative or non finite rates
+    void set_target_frame_rate(double frames_per_second);
+    double get_target_frame_rate() const;
+    bool is_capped() const;
+    // Remaining time below which waiting switches from sleeping to spinning. Should be above the
+    // scheduler granularity, ~1-2 ms on windows with timeBeginPeriod(1), much less on linux.
+    // Throws std::invalid_argument for negative or non finite values.
+    void set_spin_threshold_seconds(double seconds);
+    double get_spin_threshold_seconds() const;
+
+    // Call once per frame, e.g. after end_frame. Returns immediately when uncapped.
+    void wait_for_next_frame();
+
+    // time between two consecutive frame ends
+    const FrameStats& get_interval_stats() const;
+    // absolute difference between the frame interval and the target interval (capped only)
+    const FrameStats& get_jitter_stats() const;
+    double get_total_sleep_seconds() const;
+    double get_total_spin_seconds() const;
+    void reset_stats();
+
+private:
+    StepTimer::ClockSource _clock;
+    SleepFunction _sleep;
+    SpinFunction _spin;
+
+    double _target_frame_rate;
+    uint64_t _target_interval;
+    uint64_t _spin_threshold;
+
+    uint64_t _next_deadline;
+    bool _has_deadline;
+    uint64_t _last_frame_end;
+    bool _has_last_frame;
+
+    FrameStats _interval_stats;
+    FrameStats _jitter_stats;
+    uint64_t _sleep_ticks;
+    uint64_t _spin_ticks;
+
+    double to_seconds(uint64_t ticks) const;
+    uint64_t to_ticks(double seconds) const;
+};
\ No newline at end of file
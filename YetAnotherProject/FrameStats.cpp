@@ -0,0 +1,169 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace
+{
+    double percentile(const std::vector<uint32_t>& sorted, double p)
+    {
+        // nearest rank
+        const auto rank = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+        return sorted[std::max<std::size_t>(rank, 1) - 1] / 1000.0;
+    }
+}
+
+FrameStats::FrameStats()
+{
+    reset();
+}
+
+void FrameStats::add_sample(double seconds)
+{
+    const double us = std::clamp(seconds * 1000000.0, 0.0, static_cast<double>(UINT32_MAX));
+    const auto duration = static_cast<uint32_t>(us);
+
+    const std::size_t bucket = std::min<std::size_t>(std::bit_width(duration), bucket_count - 1);
+    _histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    // single producer, so a plain load / store pair is enough to advance the write position
+    const uint64_t index = _written.load(std::memory_order_relaxed);
+    _samples[index % capacity].store(duration, std::memory_order_relaxed);
+    _written.store(index + 1, std::memory_order_release);
+}
+
+void FrameStats::reset()
+{
+    for (auto& sample : _samples)
+        sample.store(0, std::memory_order_relaxed);
+    for (auto& bucket : _histogram)
+        bucket.store(0, std::memory_order_relaxed);
+    _written.store(0, std::memory_order_release);
+}
+
+uint64_t FrameStats::get_total_count() const
+{
+    return _written.load(std::memory_order_acquire);
+}
+
+FrameStats::Snapshot FrameStats::snapshot() const
+{
+    Snapshot result;
+    result.samples.reserve(capacity);
+    for (;;)
+    {
+        result.total_count = _written.load(std::memory_order_acquire);
+        const uint64_t count = std::min<uint64_t>(result.total_count, capacity);
+
+        result.samples.clear();
+        for (uint64_t i = result.total_count - count; i < result.total_count; ++i)
+            result.samples.push_back(_samples[i % capacity].load(std::memory_order_relaxed));
+
+        uint64_t histogram_count = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i)
+        {
+            result.histogram[i] = _histogram[i].load(std::memory_order_relaxed);
+            histogram_count += result.histogram[i];
+        }
+
+        // add_sample counts the histogram before publishing the write position, a sample in progress
+        // shows up as a histogram total above total_count, a finished one as a moved write position
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_written.load(std::memory_order_relaxed) == result.total_count && histogram_count == result.total_count)
+            return result;
+    }
+}
+
+FrameStats::Summary FrameStats::get_summary() const
+{
+    return summarize(snapshot().samples);
+}
+
+FrameStats::Summary FrameStats::summarize(std::vector<uint32_t> samples)
+{
+    Summary summary = {};
+    summary.sample_count = samples.size();
+    if (samples.empty())
+    {
+        return summary;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0.0;
+    for (auto sample : samples)
+        sum += sample;
+
+    summary.min_ms = samples.front() / 1000.0;
+    summary.max_ms = samples.back() / 1000.0;
+    summary.mean_ms = sum / samples.size() / 1000.0;
+    summary.p50_ms = percentile(samples, 0.50);
+    summary.p95_ms = percentile(samples, 0.95);
+    summary.p99_ms = percentile(samples, 0.99);
+    return summary;
+}
+
+std::array<uint64_t, FrameStats::bucket_count> FrameStats::get_histogram() const
+{
+    std::array<uint64_t, bucket_count> result;
+    for (std::size_t i = 0; i < bucket_count; ++i)
+        result[i] = _histogram[i].load(std::memory_order_relaxed);
+    return result;
+}
+
+uint64_t FrameStats::get_bucket_upper_bound_us(std::size_t bucket)
+{
+    if (bucket + 1 >= bucket_count)
+    {
+        return UINT64_MAX;
+    }
+
+    return uint64_t(1) << bucket;
+}
+
+void FrameStats::write_csv(std::ostream& out) const
+{
+    const auto snap = snapshot();
+    const auto& samples = snap.samples;
+    const uint64_t first_frame = snap.total_count - samples.size();
+
+    out << "frame,duration_ms\n";
+    for (std::size_t i = 0; i < samples.size(); ++i)
+        out << first_frame + i << ',' << samples[i] / 1000.0 << '\n';
+}
+
+void FrameStats::write_json(std::ostream& out) const
+{
+    // everything from the same copy, so it describes the same frames
+    const auto snap = snapshot();
+    const auto& samples = snap.samples;
+    const auto summary = summarize(samples);
+    const auto& histogram = snap.histogram;
+
+    out << "{\n";
+    out << "  \"summary\": { \"sample_count\": " << summary.sample_count
+        << ", \"min_ms\": " << summary.min_ms
+        << ", \"max_ms\": " << summary.max_ms
+        << ", \"mean_ms\": " << summary.mean_ms
+        << ", \"p50_ms\": " << summary.p50_ms
+        << ", \"p95_ms\": " << summary.p95_ms
+        << ", \"p99_ms\": " << summary.p99_ms << " },\n";
+
+    out << "  \"histogram\": [";
+    for (std::size_t i = 0; i < bucket_count; ++i)
+    {
+        out << (i ? ", " : "") << "{ \"upper_bound_us\": ";
+        if (i + 1 < bucket_count)
+            out << get_bucket_upper_bound_us(i);
+        else
+            out << "null";
+        out << ", \"count\": " << histogram[i] << " }";
+    }
+    out << "],\n";
+
+    out << "  \"frames_ms\": [";
+    for (std::size_t i = 0; i < samples.size(); ++i)
+        out << (i ? ", " : "") << samples[i] / 1000.0;
+    out << "]\n}\n";
+}
\ No newline at end of file
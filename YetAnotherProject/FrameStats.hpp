@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Keeps the durations of the most recent frames for percentile queries plus a histogram over all frames.
+// Samples are added by a single thread (the frame loop) without locking, queries may run on any thread.
+class FrameStats
+{
+public:
+    // number of recent frames kept for the summary
+    static constexpr std::size_t capacity = 1024;
+    // bucket 0 counts frames below 1us, bucket i frames in [2^(i-1), 2^i) us, the last one everything above
+    static constexpr std::size_t bucket_count = 24;
+
+    struct Summary
+    {
+        std::size_t sample_count;
+        double min_ms;
+        double max_ms;
+        double mean_ms;
+        double p50_ms;
+        double p95_ms;
+        double p99_ms;
+    };
+
+    FrameStats();
+
+    void add_sample(double seconds);
+    // Not thread safe, must not run concurrently with add_sample.
+    void reset();
+
+    // total number of samples added since the last reset
+    uint64_t get_total_count() const;
+    // Statistics over the last (up to) capacity frames.
+    Summary get_summary() const;
+    std::array<uint64_t, bucket_count> get_histogram() const;
+    // exclusive upper bound of a histogram bucket in microseconds
+    static uint64_t get_bucket_upper_bound_us(std::size_t bucket);
+
+    // CSV with one line per kept frame
+    void write_csv(std::ostream& out) const;
+    // JSON object with the summary, the histogram and the kept frames
+    void write_json(std::ostream& out) const;
+
+private:
+    // durations in microseconds
+    std::array<std::atomic<uint32_t>, capacity> _samples;
+    std::atomic<uint64_t> _written;
+    std::array<std::atomic<uint64_t>, bucket_count> _histogram;
+
+    struct Snapshot
+    {
+        // the kept samples, oldest first
+        std::vector<uint32_t> samples;
+        // get_total_count at the time of the copy, the newest sample is frame total_count - 1
+        uint64_t total_count;
+        // counts exactly the total_count frames
+        std::array<uint64_t, bucket_count> histogram;
+    };
+
+    // Copies the kept samples and the histogram together with the write position they were read at.
+    // Retries while the producer adds a sample during the copy, so all three describe the same frames.
+    Snapshot snapshot() const;
+    static Summary summarize(std::vector<uint32_t> samples);
+};
\ No newline at end of file
@@ -1,34 +1,62 @@
 #include "GraphicContext.hpp"
 
 #include <d3dcompiler.h>
+#include <cstddef>
 
 #include "d3dx12.h"
 #include "helper.hpp"
 #include "Vertex.hpp"
 #include "d3d12_helper.hpp"
 
-#include <DirectXMath.h>
+namespace {
+    constexpr float g_clear_color[] = { 0.0f, 0.2f, 0.4f, 1.0f };
 
-using namespace DirectX;
+    // runs first in the initializer list, before anything is sized by it
+    UINT check_frames_in_flight(uint32_t frames_in_flight)
+    {
+        if (frames_in_flight < FrameFence::min_frames_in_flight || frames_in_flight > FrameFence::max_frames_in_flight)
+        {
+            throw std::invalid_argument("GraphicContext: frames in flight must be between 2 and 4");
+        }
+        return frames_in_flight;
+    }
+}
 
-GraphicContext::GraphicContext(HWND hwnd, UINT width, UINT height)
-    : _hwnd(hwnd),
+GraphicContext::GraphicContext(HWND hwnd, UINT width, UINT height, JobSystem* job_system, const GraphicSettings& settings)
+    : _frame_count(check_frames_in_flight(settings.frames_in_flight)),
+    _vsync(settings.vsync),
+    _hwnd(hwnd),
     _width(width),
     _height(height),
+    _upload_bytes_per_frame(settings.upload_bytes_per_frame),
+    _persistent_descriptors(settings.persistent_descriptors),
+    _frame_descriptors(settings.frame_descriptors),
+    _frame_index(0),
+    _rtv_heap_size(0),
+    _render_targets(_frame_count),
+    _command_allocator(_frame_count),
+    _post_command_allocator(_frame_count),
+    _recorder(job_system),
     _assets_folder_path(get_assets_path()),
     _aspect_ratio(static_cast<float>(width) / static_cast<float>(height)),
+    _readback_buffers(_frame_count),
+    _readback_footprint(),
+    _readback_size(0),
+    _readback_pending(_frame_count, false),
+    _readback_frame_number(_frame_count, 0),
+    _frame_number(0),
     _viewport_rect{ 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height) },
     _scissor_rect{ 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) },
-    _fence_values{0, 0},
-    _vertex_buffer_view(),
-    _rtv_heap_size(0),
-    _frame_index(0),
-    _fence_event(nullptr),
-    _const_buffer(nullptr),
-    _const_buffer_data()
+    _current_constants(0)
 {
 }
 
+GraphicContext::GraphicContext(UINT width, UINT height, const std::string& output_path_prefix, ImageFormat format, JobSystem* job_system, const GraphicSettings& settings)
+    : GraphicContext(nullptr, width, height, job_system, settings)
+{
+    _image_writer = std::make_unique<ImageWriter>(output_path_prefix, format);
+}
+
 void GraphicContext::initialize()
 {
 #if defined(_DEBUG)
@@ -48,26 +76,55 @@ void GraphicContext::initialize()
 
     _device = create_device(factory.Get());
     _command_queue = create_command_queue(_device.Get());
-    _swap_chain = create_swap_chain(factory.Get(), _hwnd, _width, _height, _num_frames, _command_queue.Get());
-    _frame_index = _swap_chain->GetCurrentBackBufferIndex();
-    _rtv_heap = create_rtv_heap(_device.Get(), _num_frames);
+    _rtv_heap = create_rtv_heap(_device.Get(), _frame_count);
     _rtv_heap_size = _device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    setup_render_targets();    
-    _command_allocator[0] = create_command_allocator(_device.Get());
-    _command_allocator[1] = create_command_allocator(_device.Get());
 
-    setup_triangle_assets();
+    if (is_offscreen())
+    {
+        _frame_index = 0;
+        setup_offscreen_targets();
+    }
+    else
+    {
+        _swap_chain = create_swap_chain(factory.Get(), _hwnd, _width, _height, _frame_count, _command_queue.Get());
+        _frame_index = _swap_chain->GetCurrentBackBufferIndex();
+        setup_render_targets();
+    }
+
+    for (auto& allocator : _command_allocator)
+    {
+        allocator = create_command_allocator(_device.Get());
+    }
+
+    setup_pipeline();
 }
 
 void GraphicContext::exit()
 {
     wait_for_gpu();
 
-    CloseHandle(_fence_event);
+    if (is_offscreen())
+    {
+        // hand out the remaining frames in the order they were rendered
+        for (UINT n = 1; n <= _frame_count; n++)
+        {
+            collect_readback((_frame_index + n) % _frame_count);
+        }
+
+        _image_writer->flush();
+    }
+
+    _meshes.clear();
+    _upload_allocator.reset();
+    _upload_buffer.reset();
+    _descriptor_heap.reset();
+    _frame_fence.reset();
+    _timeline.reset();
 }
 
-void GraphicContext::setup_triangle_assets()
+void GraphicContext::setup_pipeline()
 {
+    _descriptor_heap = std::make_unique<DescriptorHeap>(_device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, _persistent_descriptors, _frame_descriptors, _frame_count);
     _root_signature = create_default_root_signature(_device.Get());
 
     // Create the pipeline state, which includes compiling and loading shaders.
@@ -114,8 +171,9 @@ void GraphicContext::setup_triangle_assets()
         // Define the vertex input layout.
         D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
         {
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(SimpleVertex, pos), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            // vec4f is 16 byte aligned, so the color does not directly follow the position
+            { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(SimpleVertex, color), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
         };
 
         // Describe and create the graphics pipeline state object (PSO).
@@ -136,68 +194,47 @@ void GraphicContext::setup_triangle_assets()
         throw_if_failed(_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&_pipeline_state)));
     }
 
-    // Create the command list.
+    // Create the command lists.
     throw_if_failed(_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, _command_allocator[0].Get(), _pipeline_state.Get(), IID_PPV_ARGS(&_command_list)));
 
     // Command lists are created in the recording state, but there is nothing
     // to record yet. The main loop expects it to be closed, so close it now.
     throw_if_failed(_command_list->Close());
 
-    // Create the vertex buffer.
+    for (UINT n = 0; n < _frame_count; n++)
     {
-        float multiplier = 1.0f;
-        float z_val = 0.5f;
-        // Define the geometry for a triangle.
-        SimpleVertex triangleVertices[] =
-        {
-            { { 0.0f, 5.0f * multiplier, z_val }, { 1.0f, 0.0f, 0.0f, 1.0f } },
-            { { 5.0f * multiplier, -5.0f * multiplier, z_val }, { 0.0f, 1.0f, 0.0f, 1.0f } },
-            { { -5.0f * multiplier, -5.0f * multiplier, z_val }, { 0.0f, 0.0f, 1.0f, 1.0f } }
-        };
-
-        const UINT vertexBufferSize = sizeof(triangleVertices);
-
-        // Note: using upload heaps to transfer static data like vert buffers is not 
-        // recommended. Every time the GPU needs it, the upload heap will be marshalled 
-        // over. Please read up on Default Heap usage. An upload heap is used here for 
-        // code simplicity and because there are very few verts to actually transfer.
-        auto heap_properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        auto resource_desc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
-        throw_if_failed(_device->CreateCommittedResource(
-            &heap_properties,
-            D3D12_HEAP_FLAG_NONE,
-            &resource_desc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&_vertex_buffer)));
-
-        // Copy the triangle data to the vertex buffer.
-        UINT8* pVertexDataBegin;
-        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-        throw_if_failed(_vertex_buffer->Map(0, &readRange, reinterpret_cast<void**>(&pVertexDataBegin)));
-        memcpy(pVertexDataBegin, triangleVertices, sizeof(triangleVertices));
-        _vertex_buffer->Unmap(0, nullptr);
-
-        // Initialize the vertex buffer view.
-        _vertex_buffer_view.BufferLocation = _vertex_buffer->GetGPUVirtualAddress();
-        _vertex_buffer_view.StrideInBytes = sizeof(SimpleVertex);
-        _vertex_buffer_view.SizeInBytes = vertexBufferSize;
+        _post_command_allocator[n] = create_command_allocator(_device.Get());
     }
+    throw_if_failed(_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, _post_command_allocator[0].Get(), nullptr, IID_PPV_ARGS(&_post_command_list)));
+    throw_if_failed(_post_command_list->Close());
 
-    // Create synchronization objects and wait until assets have been uploaded to the GPU.
+    // An allocator must not be used by two threads at once, every draw list gets its own per frame.
+    const uint32_t max_lists = _recorder.get_max_lists();
+    _draw_allocators.resize(static_cast<std::size_t>(_frame_count) * max_lists);
+    for (auto& allocator : _draw_allocators)
     {
-        throw_if_failed(_device->CreateFence(_fence_values[_frame_index], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&_fence)));
-        _fence_values[_frame_index]++;
+        allocator = create_command_allocator(_device.Get());
+    }
 
-        // Create an event handle to use for frame synchronization.
-        _fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-        if (_fence_event == nullptr)
-        {
-            throw_if_failed(HRESULT_FROM_WIN32(GetLastError()));
-        }
+    _draw_lists.resize(max_lists);
+    for (uint32_t n = 0; n < max_lists; n++)
+    {
+        throw_if_failed(_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, _draw_allocators[n].Get(), _pipeline_state.Get(), IID_PPV_ARGS(&_draw_lists[n])));
+        throw_if_failed(_draw_lists[n]->Close());
     }
 
-    _const_buffer = std::make_unique<ConstantBuffer<BasicConstBufferData> >(_device.Get());
+    // Create synchronization objects and wait until assets have been uploaded to the GPU.
+    _timeline = std::make_unique<D3D12FenceTimeline>(_device.Get(), _command_queue.Get());
+    _frame_fence = std::make_unique<FrameFence>(*_timeline, _frame_count, _frame_index);
+
+    // Mapped for the lifetime of the buffer, the allocator makes sure a region is only rewritten once
+    // the gpu finished the frame that used it.
+    _upload_buffer = create_commited_resource(_device.Get(), _upload_bytes_per_frame * _frame_count);
+    NAME_D3D12_OBJECT(_upload_buffer);
+    UINT8* upload_begin;
+    CD3DX12_RANGE read_range(0, 0);        // We do not intend to read from this resource on the CPU.
+    throw_if_failed(_upload_buffer->Map(0, &read_range, reinterpret_cast<void**>(&upload_begin)));
+    _upload_allocator = std::make_unique<UploadAllocator>(upload_begin, _upload_buffer->GetGPUVirtualAddress(), _upload_bytes_per_frame, _frame_count);
 
     // Wait for the command list to execute; we are reusing the same command 
     // list in our main loop but for now, we just want to wait for setup to 
@@ -205,138 +242,304 @@ void GraphicContext::setup_triangle_assets()
     wait_for_gpu();
 }
 
-void GraphicContext::setup_triangle_rendering()
+RenderBackend::MeshHandle GraphicContext::create_mesh(std::span<const SimpleVertex> vertices)
+{
+    Mesh mesh;
+    const UINT vertex_buffer_size = static_cast<UINT>(vertices.size_bytes());
+
+    // Note: using upload heaps to transfer static data like vert buffers is not 
+    // recommended. Every time the GPU needs it, the upload heap will be marshalled 
+    // over. Please read up on Default Heap usage. An upload heap is used here for 
+    // code simplicity and because there are very few verts to actually transfer.
+    auto heap_properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+    auto resource_desc = CD3DX12_RESOURCE_DESC::Buffer(vertex_buffer_size);
+    throw_if_failed(_device->CreateCommittedResource(
+        &heap_properties,
+        D3D12_HEAP_FLAG_NONE,
+        &resource_desc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&mesh.vertex_buffer)));
+
+    // Copy the vertices to the vertex buffer.
+    UINT8* pVertexDataBegin;
+    CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+    throw_if_failed(mesh.vertex_buffer->Map(0, &readRange, reinterpret_cast<void**>(&pVertexDataBegin)));
+    memcpy(pVertexDataBegin, vertices.data(), vertex_buffer_size);
+    mesh.vertex_buffer->Unmap(0, nullptr);
+
+    // Initialize the vertex buffer view.
+    mesh.vertex_buffer_view.BufferLocation = mesh.vertex_buffer->GetGPUVirtualAddress();
+    mesh.vertex_buffer_view.StrideInBytes = sizeof(SimpleVertex);
+    mesh.vertex_buffer_view.SizeInBytes = vertex_buffer_size;
+
+    _meshes.push_back(mesh);
+    return static_cast<MeshHandle>(_meshes.size() - 1);
+}
+
+void GraphicContext::begin_frame()
 {
     throw_if_failed(_command_allocator[_frame_index]->Reset());
     throw_if_failed(_command_list->Reset(_command_allocator[_frame_index].Get(), _pipeline_state.Get()));
 
-    // Set necessary state.
-    _command_list->SetGraphicsRootSignature(_root_signature.Get());
-
-    // setup const buffer
-    ID3D12DescriptorHeap* ppHeaps[] = { _const_buffer->get_desc_heap() };
-    _command_list->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-    _command_list->SetGraphicsRootDescriptorTable(0, _const_buffer->get_desc_heap()->GetGPUDescriptorHandleForHeapStart());
-
-    _command_list->RSSetViewports(1, &_viewport_rect);
-    _command_list->RSSetScissorRects(1, &_scissor_rect);
-
     // Indicate that the back buffer will be used as a render target.
     auto resource_barrier = CD3DX12_RESOURCE_BARRIER::Transition(_render_targets[_frame_index].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
     _command_list->ResourceBarrier(1, &resource_barrier);
 
     CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(_rtv_heap->GetCPUDescriptorHandleForHeapStart(), _frame_index, _rtv_heap_size);
-    _command_list->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+    _command_list->ClearRenderTargetView(rtvHandle, g_clear_color, 0, nullptr);
+
+    throw_if_failed(_command_list->Close());
 
-    // Record commands.
-    const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
-    _command_list->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-    _command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    _command_list->IASetVertexBuffers(0, 1, &_vertex_buffer_view);
-    _command_list->DrawInstanced(3, 1, 0, 0);
+    _frame_draws.clear();
+    _upload_allocator->begin_frame(_frame_index);
+    _descriptor_heap->begin_frame(_frame_index);
+    _current_constants = 0;
+}
 
-    // Indicate that the back buffer will now be used to present.
-    auto resource_barrier2 = CD3DX12_RESOURCE_BARRIER::Transition(_render_targets[_frame_index].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-    _command_list->ResourceBarrier(1, &resource_barrier2);
+void GraphicContext::upload_constants(const mat4f& world_view_proj)
+{
+    BasicConstBufferData data;
+    memcpy(data.world_view_proj, &world_view_proj[0][0], sizeof(world_view_proj));
+    _current_constants = _upload_allocator->push(data).gpu_address;
+}
 
-    throw_if_failed(_command_list->Close());
+void GraphicContext::draw(const DrawCall& draw_call)
+{
+    if (draw_call.mesh >= _meshes.size())
+    {
+        throw std::out_of_range("GraphicContext: draw with an unknown mesh");
+    }
+
+    // same as the other backends, draws before the first upload use identity constants
+    if (_current_constants == 0)
+    {
+        upload_constants(mat::identity());
+    }
+
+    _frame_draws.push_back({ draw_call, _current_constants });
+}
+
+void GraphicContext::end_frame()
+{
+    const uint32_t list_count = _recorder.record(_frame_draws.size(), [this](const ParallelRecorder::Range& range)
+    {
+        record_draw_list(range);
+    });
+
+    throw_if_failed(_post_command_allocator[_frame_index]->Reset());
+    throw_if_failed(_post_command_list->Reset(_post_command_allocator[_frame_index].Get(), nullptr));
+
+    if (is_offscreen())
+    {
+        // Copy the frame into this frame's readback buffer, it is mapped once the slot is reused.
+        auto to_copy_source = CD3DX12_RESOURCE_BARRIER::Transition(_render_targets[_frame_index].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        _post_command_list->ResourceBarrier(1, &to_copy_source);
+
+        CD3DX12_TEXTURE_COPY_LOCATION destination(_readback_buffers[_frame_index].Get(), _readback_footprint);
+        CD3DX12_TEXTURE_COPY_LOCATION source(_render_targets[_frame_index].Get(), 0);
+        _post_command_list->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+        // PRESENT is the same state as COMMON, which begin_frame expects
+        auto to_common = CD3DX12_RESOURCE_BARRIER::Transition(_render_targets[_frame_index].Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PRESENT);
+        _post_command_list->ResourceBarrier(1, &to_common);
+
+        _readback_pending[_frame_index] = true;
+        _readback_frame_number[_frame_index] = _frame_number;
+    }
+    else
+    {
+        // Indicate that the back buffer will now be used to present.
+        auto resource_barrier = CD3DX12_RESOURCE_BARRIER::Transition(_render_targets[_frame_index].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+        _post_command_list->ResourceBarrier(1, &resource_barrier);
+    }
+
+    throw_if_failed(_post_command_list->Close());
+
+    // Execute all lists of the frame at once, the draw lists in the order of their ranges.
+    _submit_lists.clear();
+    _submit_lists.push_back(_command_list.Get());
+    for (uint32_t n = 0; n < list_count; n++)
+    {
+        _submit_lists.push_back(_draw_lists[n].Get());
+    }
+    _submit_lists.push_back(_post_command_list.Get());
+    _command_queue->ExecuteCommandLists(static_cast<UINT>(_submit_lists.size()), _submit_lists.data());
+
+    // Present the frame.
+    if (!is_offscreen())
+    {
+        throw_if_failed(_swap_chain->Present(_vsync ? 1 : 0, 0));
+    }
+
+    _frame_number++;
+    move_to_next_frame();
+}
+
+// Command lists don't inherit any state, every draw list sets everything up on its own.
+void GraphicContext::set_draw_state(ID3D12GraphicsCommandList* command_list)
+{
+    command_list->SetGraphicsRootSignature(_root_signature.Get());
+    // one heap for everything, it never has to be switched within a list
+    ID3D12DescriptorHeap* heaps[] = { _descriptor_heap->get_heap() };
+    command_list->SetDescriptorHeaps(_countof(heaps), heaps);
+
+    command_list->RSSetViewports(1, &_viewport_rect);
+    command_list->RSSetScissorRects(1, &_scissor_rect);
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(_rtv_heap->GetCPUDescriptorHandleForHeapStart(), _frame_index, _rtv_heap_size);
+    command_list->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+    command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
-float g_ft_acc = 0.0f;
+// Runs on a job system thread, only touches the list and allocator of its range.
+void GraphicContext::record_draw_list(const ParallelRecorder::Range& range)
+{
+    auto& allocator = _draw_allocators[static_cast<std::size_t>(_frame_index) * _recorder.get_max_lists() + range.list_index];
+    auto& command_list = _draw_lists[range.list_index];
+    throw_if_failed(allocator->Reset());
+    throw_if_failed(command_list->Reset(allocator.Get(), _pipeline_state.Get()));
 
-// Somehow M_PI is not defined even tho intellisense recognizes it with use math defines :(
-const float g_pi_value = 3.14159265358979323846f;
+    set_draw_state(command_list.Get());
 
-const float g_fov = g_pi_value * 0.75f;
-const float g_aspect = 800.0f / 600.0f;
-const float g_near_z = 0.1f;
-const float g_far_z = 10.0f;
+    D3D12_GPU_VIRTUAL_ADDRESS bound_constants = 0;
+    for (std::size_t i = range.first; i < range.first + range.count; i++)
+    {
+        const QueuedDraw& queued = _frame_draws[i];
+        if (queued.constants != bound_constants)
+        {
+            command_list->SetGraphicsRootConstantBufferView(0, queued.constants);
+            bound_constants = queued.constants;
+        }
 
-vec3f g_eye = vec3f(4.0f, 3.0f, -3.0f);
-vec3f g_at = vec3f(0.0f, 0.0f, 0.0f);
-vec3f g_up = vec3f(0.0f, 1.0f, 0.0f);
+        const DrawCall& draw_call = queued.draw_call;
+        command_list->IASetVertexBuffers(0, 1, &_meshes[draw_call.mesh].vertex_buffer_view);
+        command_list->DrawInstanced(draw_call.vertex_count, 1, draw_call.start_vertex, 0);
+    }
 
-mat4f g_view = mat::look_at(g_eye, g_at, g_up);
-mat4f g_proj = mat::proj(g_fov, g_aspect, g_near_z, g_far_z);
+    throw_if_failed(command_list->Close());
+}
 
-XMVECTOR vec_to_xmvec(const vec3f& vec)
+bool GraphicContext::is_offscreen() const
 {
-    const auto xmfloat = XMFLOAT3(&vec.data[0]);
-    return XMLoadFloat3(&xmfloat);
+    return _image_writer != nullptr;
 }
 
-void GraphicContext::triangle_render(float frametime)
+uint32_t GraphicContext::get_frames_in_flight() const
 {
-    // DirectX::XMFLOAT4X4 float4x4;
-    // const auto mvp = mat::translate(vec3f(0, 0, 60));
-    // const auto dx_mvp = DirectX::XMMatrixTranslation(0, 0, 60);
-    // const auto mvp = mat::look_at(g_eye, g_at, g_up);
-    // const auto dx_mvp = XMMatrixLookAtLH(vec_to_xmvec(g_eye), vec_to_xmvec(g_at), vec_to_xmvec(g_up));
-    /*const auto mvp = mat::proj(g_fov, g_aspect, g_near_z, g_far_z) * mat::look_at(g_eye, g_at, g_up);
-    const auto dx_mvp = XMMatrixLookAtLH(vec_to_xmvec(g_eye), vec_to_xmvec(g_at), vec_to_xmvec(g_up)) * XMMatrixPerspectiveFovLH(g_fov, g_aspect, g_near_z, g_far_z);
-    XMStoreFloat4x4(&float4x4, XMMatrixTranspose(dx_mvp));
-    memcpy(_const_buffer_data.dx_world_view_proj, &float4x4, sizeof(float4x4));*/
-
-    const auto mvp = mat::proj(g_fov, g_aspect, g_near_z, g_far_z) * mat::look_at(g_eye, g_at, g_up);
-    memcpy(_const_buffer_data.world_view_proj, &mvp[0][0], sizeof(mvp));
-    _const_buffer->update_buffer_data(_const_buffer_data);
-
-    // Record all the commands we need to render the scene into the command list.
-    setup_triangle_rendering();
-
-    // Execute the command list.
-    ID3D12CommandList* ppCommandLists[] = { _command_list.Get() };
-    _command_queue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    return _frame_count;
+}
 
-    // Present the frame.
-    throw_if_failed(_swap_chain->Present(1, 0));
+double GraphicContext::get_last_gpu_wait_seconds() const
+{
+    return _frame_fence->get_last_wait_seconds();
+}
 
-    move_to_next_frame();    
+const FrameStats& GraphicContext::get_gpu_wait_stats() const
+{
+    return _frame_fence->get_wait_stats();
 }
 
-// Wait for pending GPU work to complete.
-void GraphicContext::wait_for_gpu()
+const UploadAllocator& GraphicContext::get_upload_allocator() const
 {
-    // Schedule a Signal command in the queue.
-    throw_if_failed(_command_queue->Signal(_fence.Get(), _fence_values[_frame_index]));
+    return *_upload_allocator;
+}
 
-    // Wait until the fence has been processed.
-    throw_if_failed(_fence->SetEventOnCompletion(_fence_values[_frame_index], _fence_event));
-    WaitForSingleObjectEx(_fence_event, INFINITE, FALSE);
+DescriptorHeap& GraphicContext::get_descriptor_heap()
+{
+    return *_descriptor_heap;
+}
 
-    // Increment the fence value for the current frame.
-    _fence_values[_frame_index]++;
+// Wait for pending GPU work to complete.
+void GraphicContext::wait_for_gpu()
+{
+    _frame_fence->wait_for_idle();
 }
 
 // Prepare to render the next frame.
 void GraphicContext::move_to_next_frame()
 {
-    // Schedule a Signal command in the queue.
-    const UINT64 currentFenceValue = _fence_values[_frame_index];
-    throw_if_failed(_command_queue->Signal(_fence.Get(), currentFenceValue));
+    // waits if the gpu still works on the frame that last used the next slot
+    _frame_fence->advance(is_offscreen() ? (_frame_index + 1) % _frame_count : _swap_chain->GetCurrentBackBufferIndex());
+    _frame_index = _frame_fence->get_frame_index();
 
-    // Update the frame index.
-    _frame_index = _swap_chain->GetCurrentBackBufferIndex();
-
-    // If the next frame is not ready to be rendered yet, wait until it is ready.
-    if (_fence->GetCompletedValue() < _fence_values[_frame_index])
+    // the gpu is done with the previous frame in this slot, its readback can be handed to the writer
+    if (is_offscreen())
     {
-        throw_if_failed(_fence->SetEventOnCompletion(_fence_values[_frame_index], _fence_event));
-        WaitForSingleObjectEx(_fence_event, INFINITE, FALSE);
+        collect_readback(_frame_index);
     }
-
-    // Set the fence value for the next frame.
-    _fence_values[_frame_index] = currentFenceValue + 1;
 }
 
 void GraphicContext::setup_render_targets()
 {
     CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(_rtv_heap->GetCPUDescriptorHandleForHeapStart());
 
-    for (UINT n = 0; n < _num_frames; n++)
+    for (UINT n = 0; n < _frame_count; n++)
     {
         throw_if_failed(_swap_chain->GetBuffer(n, IID_PPV_ARGS(&_render_targets[n])));
         _device->CreateRenderTargetView(_render_targets[n].Get(), nullptr, rtvHandle);
         rtvHandle.Offset(1, _rtv_heap_size);
     }
+}
+
+void GraphicContext::setup_offscreen_targets()
+{
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(_rtv_heap->GetCPUDescriptorHandleForHeapStart());
+
+    auto default_heap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    auto texture_desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, _width, _height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+    CD3DX12_CLEAR_VALUE clear_value(DXGI_FORMAT_R8G8B8A8_UNORM, g_clear_color);
+
+    // rows of the readback buffers are padded to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+    _device->GetCopyableFootprints(&texture_desc, 0, 1, 0, &_readback_footprint, nullptr, nullptr, &_readback_size);
+    auto readback_heap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+    auto readback_desc = CD3DX12_RESOURCE_DESC::Buffer(_readback_size);
+
+    for (UINT n = 0; n < _frame_count; n++)
+    {
+        throw_if_failed(_device->CreateCommittedResource(
+            &default_heap,
+            D3D12_HEAP_FLAG_NONE,
+            &texture_desc,
+            D3D12_RESOURCE_STATE_COMMON,
+            &clear_value,
+            IID_PPV_ARGS(&_render_targets[n])));
+        _device->CreateRenderTargetView(_render_targets[n].Get(), nullptr, rtvHandle);
+        rtvHandle.Offset(1, _rtv_heap_size);
+
+        throw_if_failed(_device->CreateCommittedResource(
+            &readback_heap,
+            D3D12_HEAP_FLAG_NONE,
+            &readback_desc,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&_readback_buffers[n])));
+    }
+}
+
+// Must only be called once the gpu finished the frame in this slot.
+void GraphicContext::collect_readback(UINT frame_index)
+{
+    if (!_readback_pending[frame_index])
+    {
+        return;
+    }
+
+    _readback_pending[frame_index] = false;
+
+    UINT8* data;
+    CD3DX12_RANGE read_range(0, static_cast<SIZE_T>(_readback_size));
+    throw_if_failed(_readback_buffers[frame_index]->Map(0, &read_range, reinterpret_cast<void**>(&data)));
+
+    const std::size_t row_size = static_cast<std::size_t>(_width) * 4;
+    std::vector<uint8_t> rgba(row_size * _height);
+    for (UINT y = 0; y < _height; y++)
+    {
+        memcpy(rgba.data() + y * row_size, data + _readback_footprint.Offset + y * _readback_footprint.Footprint.RowPitch, row_size);
+    }
+
+    CD3DX12_RANGE write_range(0, 0);        // Nothing was written.
+    _readback_buffers[frame_index]->Unmap(0, &write_range);
+
+    _image_writer->write(_readback_frame_number[frame_index], _width, _height, std::move(rgba));
 }
\ No newline at end of file
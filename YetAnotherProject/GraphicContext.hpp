@@ -6,34 +6,90 @@
 using namespace Microsoft::WRL;
 #include <d3d12.h>
 #include <dxgi1_6.h>
+#include <memory>
 #include <string>
+#include <vector>
 #include "d3dx12.h"
 
 #include "mat4.hpp"
-#include "ConstantBuffer.hpp"
+#include "d3d12_helper.hpp"
+#include "DescriptorHeap.hpp"
+#include "FrameFence.hpp"
+#include "ImageWriter.hpp"
+#include "ParallelRecorder.hpp"
+#include "RenderBackend.hpp"
+#include "UploadAllocator.hpp"
 
-class GraphicContext
+struct GraphicSettings
+{
+	// Frames the cpu may record ahead of the gpu, 2 to 4. More frames hide gpu hiccups and keep both
+	// busy, but every frame adds a frame of input latency.
+	uint32_t frames_in_flight = 2;
+	// Present waits for the vertical blank. Turn off to measure throughput or to pace frames with a FramePacer.
+	bool vsync = true;
+	// Upload memory for the per draw constants of one frame, 256 bytes per draw. Exceeding it throws.
+	uint64_t upload_bytes_per_frame = 1 << 20;
+	// Slots of the shared cbv/srv/uav heap: views that live as long as their resource and per frame tables.
+	uint32_t persistent_descriptors = 4096;
+	uint32_t frame_descriptors = 1024;
+};
+
+class GraphicContext : public RenderBackend
 {
 	struct BasicConstBufferData
 	{
 		float world_view_proj[16];
-		float dx_world_view_proj[16];
 	};
 public:
-	GraphicContext(HWND hwnd, UINT width, UINT height);
-	void initialize();
-	void exit();
+	// With a job system the draws of a frame are recorded into several command lists in parallel.
+	GraphicContext(HWND hwnd, UINT width, UINT height, JobSystem* job_system = nullptr, const GraphicSettings& settings = GraphicSettings());
+	// Off-screen mode without window and swap chain. Frames are rendered into owned render targets, copied
+	// to readback buffers and written to <output_path_prefix><frame number>.ppm/png by a writer thread.
+	// A readback is only mapped once its frame slot comes around again, so it never stalls the gpu.
+	GraphicContext(UINT width, UINT height, const std::string& output_path_prefix, ImageFormat format, JobSystem* job_system = nullptr, const GraphicSettings& settings = GraphicSettings());
+	void initialize() override;
+	void exit() override;
 
-	void setup_triangle_assets();
-	void setup_triangle_rendering();
+	MeshHandle create_mesh(std::span<const SimpleVertex> vertices) override;
 
-	void triangle_render(float frametime);
+	void begin_frame() override;
+	// Every upload gets its own slice of the frame's upload memory, draws reference the last one by a root cbv.
+	void upload_constants(const mat4f& world_view_proj) override;
+	// Draws are collected and recorded in end_frame.
+	void draw(const DrawCall& draw_call) override;
+	// Submits the recorded frame and presents it (or queues its readback when off-screen).
+	void end_frame() override;
+
+	bool is_offscreen() const;
+	uint32_t get_frames_in_flight() const;
+	// time the cpu waited for the gpu to release a frame slot in the last end_frame
+	double get_last_gpu_wait_seconds() const;
+	const FrameStats& get_gpu_wait_stats() const;
+	const UploadAllocator& get_upload_allocator() const;
+	// the shader visible cbv/srv/uav heap every command list of the frame is bound to
+	DescriptorHeap& get_descriptor_heap();
 
 private:
-	static const uint8_t _num_frames = 2;
+	struct Mesh
+	{
+		ComPtr<ID3D12Resource> vertex_buffer;
+		D3D12_VERTEX_BUFFER_VIEW vertex_buffer_view;
+	};
+
+	struct QueuedDraw
+	{
+		DrawCall draw_call;
+		D3D12_GPU_VIRTUAL_ADDRESS constants;
+	};
+
+	UINT _frame_count;
+	bool _vsync;
 	HWND _hwnd;
 	UINT _width;
 	UINT _height;
+	uint64_t _upload_bytes_per_frame;
+	uint32_t _persistent_descriptors;
+	uint32_t _frame_descriptors;
 
 	ComPtr<ID3D12Device> _device;
 	ComPtr<ID3D12CommandQueue> _command_queue;
@@ -41,33 +97,60 @@ private:
 	UINT _frame_index;
 	ComPtr<ID3D12DescriptorHeap> _rtv_heap;
 	UINT _rtv_heap_size;
-	ComPtr<ID3D12Resource> _render_targets[_num_frames];
+	std::vector<ComPtr<ID3D12Resource> > _render_targets;
 	ComPtr<ID3D12GraphicsCommandList> _command_list;
-	ComPtr<ID3D12CommandAllocator> _command_allocator[_num_frames];
+	std::vector<ComPtr<ID3D12CommandAllocator> > _command_allocator;
+
+	// _command_list starts a frame (barrier, clear), the draws are split across _draw_lists
+	// which are recorded in parallel and _post_command_list ends the frame
+	ComPtr<ID3D12GraphicsCommandList> _post_command_list;
+	std::vector<ComPtr<ID3D12CommandAllocator> > _post_command_allocator;
+	ParallelRecorder _recorder;
+	std::vector<ComPtr<ID3D12GraphicsCommandList> > _draw_lists;
+	// one per frame and draw list, frame index * max lists + list index
+	std::vector<ComPtr<ID3D12CommandAllocator> > _draw_allocators;
+	std::vector<QueuedDraw> _frame_draws;
+	std::vector<ID3D12CommandList*> _submit_lists;
 
+	std::unique_ptr<DescriptorHeap> _descriptor_heap;
 	ComPtr<ID3D12RootSignature> _root_signature;
 	ComPtr<ID3D12PipelineState> _pipeline_state;
 
 	std::wstring _assets_folder_path;
 	float _aspect_ratio;
 
-	ComPtr<ID3D12Resource> _vertex_buffer;
-	D3D12_VERTEX_BUFFER_VIEW _vertex_buffer_view;
+	std::vector<Mesh> _meshes;
 
 	// Synchronization objects.
-	HANDLE _fence_event;
-	ComPtr<ID3D12Fence> _fence;
-	UINT64 _fence_values[_num_frames];
+	std::unique_ptr<D3D12FenceTimeline> _timeline;
+	std::unique_ptr<FrameFence> _frame_fence;
+
+	// off-screen mode
+	std::unique_ptr<ImageWriter> _image_writer;
+	std::vector<ComPtr<ID3D12Resource> > _readback_buffers;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT _readback_footprint;
+	UINT64 _readback_size;
+	std::vector<bool> _readback_pending;
+	std::vector<uint64_t> _readback_frame_number;
+	uint64_t _frame_number;
 
 	CD3DX12_VIEWPORT _viewport_rect;
 	CD3DX12_RECT _scissor_rect;
 
-	// real properties!
-	std::unique_ptr<ConstantBuffer<BasicConstBufferData> > _const_buffer;
-	BasicConstBufferData _const_buffer_data;
+	// one persistently mapped upload buffer, split into a region per frame slot by _upload_allocator
+	ComPtr<ID3D12Resource> _upload_buffer;
+	std::unique_ptr<UploadAllocator> _upload_allocator;
+	// gpu address of the last uploaded constants of this frame, 0 before the first upload
+	D3D12_GPU_VIRTUAL_ADDRESS _current_constants;
 
 	void wait_for_gpu();
 	void move_to_next_frame();
-	
+
+	void setup_pipeline();
+	void set_draw_state(ID3D12GraphicsCommandList* command_list);
+	void record_draw_list(const ParallelRecorder::Range& range);
+
 	void setup_render_targets();
+	void setup_offscreen_targets();
+	void collect_readback(UINT frame_index);
 };
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include "ImageWriter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    void check_size(uint32_t width, uint32_t height, std::span<const uint8_t> rgba)
+    {
+        if (rgba.size() != static_cast<std::size_t>(width) * height * 4)
+        {
+            throw std::invalid_argument("image size does not match the pixel data");
+        }
+    }
+
+    std::array<uint32_t, 256> make_crc_table()
+    {
+        std::array<uint32_t, 256> table;
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }
+
+    uint32_t update_crc(uint32_t crc, std::span<const uint8_t> data)
+    {
+        static const auto table = make_crc_table();
+        for (const uint8_t b : data)
+        {
+            crc = table[(crc ^ b) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    void append_u32_be(std::vector<uint8_t>& out, uint32_t v)
+    {
+        out.push_back(static_cast<uint8_t>(v >> 24));
+        out.push_back(static_cast<uint8_t>(v >> 16));
+        out.push_back(static_cast<uint8_t>(v >> 8));
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    void write_chunk(std::ostream& out, const char (&type)[5], std::span<const uint8_t> data)
+    {
+        std::vector<uint8_t> header;
+        append_u32_be(header, static_cast<uint32_t>(data.size()));
+        header.insert(header.end(), type, type + 4);
+
+        uint32_t crc = update_crc(0xFFFFFFFFu, std::span<const uint8_t>(header).subspan(4));
+        crc = update_crc(crc, data) ^ 0xFFFFFFFFu;
+
+        std::vector<uint8_t> footer;
+        append_u32_be(footer, crc);
+
+        out.write(reinterpret_cast<const char*>(header.data()), header.size());
+        out.write(reinterpret_cast<const char*>(data.data()), data.size());
+        out.write(reinterpret_cast<const char*>(footer.data()), footer.size());
+    }
+}
+
+void write_ppm(std::ostream& out, uint32_t width, uint32_t height, std::span<const uint8_t> rgba)
+{
+    check_size(width, height, rgba);
+
+    out << "P6\n" << width << ' ' << height << "\n255\n";
+
+    std::vector<uint8_t> row(static_cast<std::size_t>(width) * 3);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint8_t* src = rgba.data() + static_cast<std::size_t>(y) * width * 4;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        out.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+}
+
+void write_png(std::ostream& out, uint32_t width, uint32_t height, std::span<const uint8_t> rgba)
+{
+    check_size(width, height, rgba);
+
+    static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> ihdr;
+    append_u32_be(ihdr, width);
+    append_u32_be(ihdr, height);
+    ihdr.push_back(8);    // bit depth
+    ihdr.push_back(6);    // color type rgba
+    ihdr.push_back(0);    // compression
+    ihdr.push_back(0);    // filter
+    ihdr.push_back(0);    // no interlacing
+    write_chunk(out, "IHDR", ihdr);
+
+    // every row is prefixed by its filter type, 0 = none
+    const std::size_t row_size = static_cast<std::size_t>(width) * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((row_size + 1) * height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba.begin() + y * row_size, rgba.begin() + (y + 1) * row_size);
+    }
+
+    // zlib stream of stored deflate blocks (at most 65535 bytes each) followed by the adler32 checksum
+    const std::size_t max_block = 65535;
+    std::vector<uint8_t> idat;
+    idat.reserve(raw.size() + raw.size() / max_block * 5 + 16);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+
+    std::size_t offset = 0;
+    do
+    {
+        const std::size_t block_size = std::min(max_block, raw.size() - offset);
+        const bool last = offset + block_size == raw.size();
+        const uint16_t len = static_cast<uint16_t>(block_size);
+        const uint16_t nlen = static_cast<uint16_t>(~len);
+
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(static_cast<uint8_t>(len));
+        idat.push_back(static_cast<uint8_t>(len >> 8));
+        idat.push_back(static_cast<uint8_t>(nlen));
+        idat.push_back(static_cast<uint8_t>(nlen >> 8));
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + block_size);
+        offset += block_size;
+    } while (offset < raw.size());
+
+    uint32_t a = 1, b = 0;
+    for (const uint8_t v : raw)
+    {
+        a = (a + v) % 65521;
+        b = (b + a) % 65521;
+    }
+    append_u32_be(idat, (b << 16) | a);
+
+    write_chunk(out, "IDAT", idat);
+    write_chunk(out, "IEND", {});
+}
+
+void write_image(const std::string& path, ImageFormat format, uint32_t width, uint32_t height, std::span<const uint8_t> rgba)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        throw std::runtime_error("can't open " + path + " for writing");
+    }
+
+    if (format == ImageFormat::png)
+    {
+        write_png(out, width, height, rgba);
+    }
+    else
+    {
+        write_ppm(out, width, height, rgba);
+    }
+
+    if (!out.flush())
+    {
+        throw std::runtime_error("failed writing " + path);
+    }
+}
+
+ImageWriter::ImageWriter(std::string path_prefix, ImageFormat format, std::size_t max_queued_frames)
+    : _path_prefix(std::move(path_prefix)),
+    _format(format),
+    _max_queued_frames(max_queued_frames),
+    _busy(false),
+    _stop(false),
+    _written_count(0)
+{
+    if (max_queued_frames == 0)
+    {
+        throw std::invalid_argument("ImageWriter: max_queued_frames must be at least 1");
+    }
+
+    // started once the arguments are checked, a throwing constructor must not leave a joinable thread behind
+    _thread = std::thread(&ImageWriter::run, this);
+}
+
+ImageWriter::~ImageWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _queue_changed.notify_all();
+    _thread.join();
+}
+
+void ImageWriter::write(uint64_t frame_number, uint32_t width, uint32_t height, std::vector<uint8_t> rgba)
+{
+    check_size(width, height, rgba);
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _queue_changed.wait(lock, [this] { return _queue.size() < _max_queued_frames || _error; });
+        rethrow_error();
+        _queue.push_back({ frame_number, width, height, std::move(rgba) });
+    }
+    _queue_changed.notify_all();
+}
+
+void ImageWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _queue_changed.wait(lock, [this] { return _queue.empty() && !_busy; });
+    rethrow_error();
+}
+
+uint64_t ImageWriter::get_written_count() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _written_count;
+}
+
+std::string ImageWriter::get_path(uint64_t frame_number) const
+{
+    char number[32];
+    std::snprintf(number, sizeof(number), "%06llu", static_cast<unsigned long long>(frame_number));
+    return _path_prefix + number + (_format == ImageFormat::png ? ".png" : ".ppm");
+}
+
+void ImageWriter::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        _queue_changed.wait(lock, [this] { return !_queue.empty() || _stop; });
+        if (_queue.empty())
+        {
+            return;
+        }
+
+        Frame frame = std::move(_queue.front());
+        _queue.pop_front();
+        _busy = true;
+        lock.unlock();
+        // room for a blocked write
+        _queue_changed.notify_all();
+
+        std::exception_ptr error;
+        try
+        {
+            write_image(get_path(frame.frame_number), _format, frame.width, frame.height, frame.rgba);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        _busy = false;
+        if (error)
+        {
+            if (!_error)
+            {
+                _error = error;
+            }
+        }
+        else
+        {
+            _written_count++;
+        }
+        _queue_changed.notify_all();
+    }
+}
+
+void ImageWriter::rethrow_error()
+{
+    if (_error)
+    {
+        auto error = _error;
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ImageFormat
+{
+    ppm,
+    png
+};
+
+// Encoders for tightly packed RGBA8 images, rows top to bottom. ppm drops the alpha channel,
+// png is written with uncompressed (stored) deflate blocks, which keeps it fast and free of dependencies.
+void write_ppm(std::ostream& out, uint32_t width, uint32_t height, std::span<const uint8_t> rgba);
+void write_png(std::ostream& out, uint32_t width, uint32_t height, std::span<const uint8_t> rgba);
+// throws std::runtime_error when the file can't be written
+void write_image(const std::string& path, ImageFormat format, uint32_t width, uint32_t height, std::span<const uint8_t> rgba);
+
+// Writes frames to numbered files (<path_prefix>000042.png) on its own thread, so encoding and disk io
+// never block the render thread. Errors of the writer thread are rethrown by the next write / flush.
+class ImageWriter
+{
+public:
+    // every queued frame holds a full copy of its pixels
+    static constexpr std::size_t default_max_queued_frames = 3;
+
+    // throws std::invalid_argument if max_queued_frames is 0
+    ImageWriter(std::string path_prefix, ImageFormat format, std::size_t max_queued_frames = default_max_queued_frames);
+    // writes all queued frames before returning
+    ~ImageWriter();
+
+    // Blocks while max_queued_frames frames are waiting, so rendering slows down to the speed of the
+    // encoder / disk instead of piling up frames in memory. No frame is dropped.
+    void write(uint64_t frame_number, uint32_t width, uint32_t height, std::vector<uint8_t> rgba);
+    // blocks until all queued frames are written
+    void flush();
+
+    uint64_t get_written_count() const;
+    std::string get_path(uint64_t frame_number) const;
+
+private:
+    struct Frame
+    {
+        uint64_t frame_number;
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> rgba;
+    };
+
+    std::string _path_prefix;
+    ImageFormat _format;
+    std::size_t _max_queued_frames;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _queue_changed;
+    std::deque<Frame> _queue;
+    bool _busy;
+    bool _stop;
+    uint64_t _written_count;
+    std::exception_ptr _error;
+
+    std::thread _thread;
+
+    void run();
+    void rethrow_error();
+};
\ No newline at end of file
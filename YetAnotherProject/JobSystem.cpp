@@ -0,0 +1,223 @@
+#include "JobSystem.hpp"
+
+namespace {
+    thread_local JobSystem* g_current_system = nullptr;
+    thread_local uint32_t g_current_thread_index = 0;
+}
+
+JobCounter::JobCounter()
+    : _pending(0)
+{
+}
+
+bool JobCounter::is_done() const
+{
+    if (_pending.load(std::memory_order_acquire) != 0)
+    {
+        return false;
+    }
+
+    // The last job drops the counter to zero while holding the lock. Taking it here makes sure that
+    // job is done touching the counter, the waiting thread may destroy it right after.
+    std::lock_guard<std::mutex> lock(_mutex);
+    return true;
+}
+
+uint32_t JobCounter::get_pending() const
+{
+    return _pending.load(std::memory_order_acquire);
+}
+
+JobSystem::JobSystem(uint32_t worker_count)
+    : _queued(0),
+    _stop(false)
+{
+    if (worker_count == 0)
+    {
+        // hardware_concurrency may return 0 when it is unknown, keep at least one worker
+        worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    for (uint32_t i = 0; i <= worker_count; ++i)
+    {
+        _queues.push_back(std::make_unique<Queue>());
+    }
+
+    for (uint32_t i = 1; i <= worker_count; ++i)
+    {
+        _workers.emplace_back(&JobSystem::worker_main, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _stop = true;
+    }
+    _work_available.notify_all();
+
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::run(Job job, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    push({ std::move(job), counter });
+}
+
+void JobSystem::run_after(JobCounter& dependency, Job job, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        // finish drops the counter to zero under the same lock, so either it sees the continuation or we see the zero
+        std::lock_guard<std::mutex> lock(dependency._mutex);
+        if (dependency._pending.load(std::memory_order_acquire) != 0)
+        {
+            dependency._continuations.push_back({ std::move(job), counter });
+            return;
+        }
+    }
+
+    push({ std::move(job), counter });
+}
+
+void JobSystem::wait(const JobCounter& counter)
+{
+    const uint32_t thread_index = g_current_system == this ? g_current_thread_index : 0;
+
+    while (!counter.is_done())
+    {
+        Task task;
+        if (try_pop(thread_index, task))
+        {
+            execute(task);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint32_t JobSystem::get_thread_count() const
+{
+    return static_cast<uint32_t>(_workers.size()) + 1;
+}
+
+uint32_t JobSystem::get_current_thread_index()
+{
+    return g_current_thread_index;
+}
+
+void JobSystem::push(Task task)
+{
+    const uint32_t thread_index = g_current_system == this ? g_current_thread_index : 0;
+    {
+        std::lock_guard<std::mutex> lock(_queues[thread_index]->mutex);
+        _queues[thread_index]->tasks.push_back(std::move(task));
+    }
+
+    _queued.fetch_add(1, std::memory_order_release);
+    {
+        // pairs with the predicate check of the sleeping workers, otherwise the notify could get lost
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+    }
+    _work_available.notify_one();
+}
+
+bool JobSystem::try_pop(uint32_t thread_index, Task& task)
+{
+    // own queue first, newest job
+    {
+        Queue& own = *_queues[thread_index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // steal the oldest job of another queue, starting with the neighbour to spread the thieves
+    const std::size_t queue_count = _queues.size();
+    for (std::size_t i = 1; i < queue_count; ++i)
+    {
+        Queue& victim = *_queues[(thread_index + i) % queue_count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::execute(Task& task)
+{
+    task.job();
+
+    if (task.counter)
+    {
+        finish(*task.counter);
+    }
+}
+
+void JobSystem::finish(JobCounter& counter)
+{
+    std::vector<JobCounter::Continuation> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter._mutex);
+        if (counter._pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        continuations.swap(counter._continuations);
+    }
+
+    for (auto& continuation : continuations)
+    {
+        push({ std::move(continuation.job), continuation.counter });
+    }
+}
+
+void JobSystem::worker_main(uint32_t thread_index)
+{
+    g_current_system = this;
+    g_current_thread_index = thread_index;
+
+    for (;;)
+    {
+        Task task;
+        if (try_pop(thread_index, task))
+        {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleep_mutex);
+        _work_available.wait(lock, [this] { return _stop || _queued.load(std::memory_order_acquire) > 0; });
+        if (_stop && _queued.load(std::memory_order_acquire) == 0)
+        {
+            return;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Counts the unfinished jobs of a group. Jobs can be started once a counter reaches zero (run_after)
+// and threads can wait for it, executing other jobs in the meantime. Can be reused once it reached zero.
+class JobCounter
+{
+public:
+    JobCounter();
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator = (const JobCounter&) = delete;
+
+    bool is_done() const;
+    uint32_t get_pending() const;
+
+private:
+    friend class JobSystem;
+
+    struct Continuation
+    {
+        std::function<void()> job;
+        JobCounter* counter;
+    };
+
+    std::atomic<uint32_t> _pending;
+    mutable std::mutex _mutex;
+    std::vector<Continuation> _continuations;
+};
+
+// Fixed pool of worker threads, each with its own deque. A worker pushes and pops jobs at the back
+// of its own deque (most recent first, the data is likely still in cache) and steals from the front
+// of the others when it runs out. Threads that aren't workers (e.g. the main thread) push to a shared
+// queue and execute jobs while they wait for a counter.
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+
+    // worker_count 0 uses one worker per hardware thread except the calling one, which helps out in wait
+    explicit JobSystem(uint32_t worker_count = 0);
+    // finishes all queued jobs
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator = (const JobSystem&) = delete;
+
+    // counter is incremented now and decremented when the job has finished
+    void run(Job job, JobCounter* counter = nullptr);
+    // starts job once dependency reaches zero (immediately if it already is)
+    void run_after(JobCounter& dependency, Job job, JobCounter* counter = nullptr);
+    // executes queued jobs until the counter reaches zero
+    void wait(const JobCounter& counter);
+
+    // Calls fn(chunk_begin, chunk_end) for chunks of at most grain_size indices of [begin, end) in parallel
+    // and returns once all are done. grain_size 0 splits the range into a few chunks per thread.
+    // Rethrows the first exception thrown by fn.
+    template <typename Fn>
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain_size, const Fn& fn)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+
+        const std::size_t count = end - begin;
+        if (grain_size == 0)
+        {
+            grain_size = std::max<std::size_t>(1, count / (static_cast<std::size_t>(get_thread_count()) * 4));
+        }
+
+        // a job must not throw on a worker, the first exception is passed on to the caller instead
+        JobCounter counter;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+        for (std::size_t chunk = begin; chunk < end; chunk += grain_size)
+        {
+            const std::size_t chunk_end = std::min(end, chunk + grain_size);
+            run([&fn, &error_mutex, &error, chunk, chunk_end]
+            {
+                try
+                {
+                    fn(chunk, chunk_end);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+            }, &counter);
+        }
+
+        wait(counter);
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // workers plus the thread waiting on the jobs
+    uint32_t get_thread_count() const;
+    // 0 on threads that aren't workers of any job system, 1..worker count on the workers.
+    // Can be used to index per thread data.
+    static uint32_t get_current_thread_index();
+
+private:
+    struct Task
+    {
+        Job job;
+        JobCounter* counter;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // index 0 is the shared queue of the non worker threads
+    std::vector<std::unique_ptr<Queue> > _queues;
+    std::vector<std::thread> _workers;
+
+    std::atomic<uint64_t> _queued;
+    std::mutex _sleep_mutex;
+    std::condition_variable _work_available;
+    bool _stop;
+
+    void push(Task task);
+    bool try_pop(uint32_t thread_index, Task& task);
+    void execute(Task& task);
+    void finish(JobCounter& counter);
+    void worker_main(uint32_t thread_index);
+};
\ No newline at end of file
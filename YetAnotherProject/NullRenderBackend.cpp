@@ -0,0 +1,106 @@
+#include "NullRenderBackend.hpp"
+
+#include <stdexcept>
+
+NullRenderBackend::NullRenderBackend(JobSystem* job_system)
+    : _in_frame(false),
+    _constants(mat::identity()),
+    _recorder(job_system),
+    _frame_count(0),
+    _total_draw_count(0)
+{
+}
+
+void NullRenderBackend::initialize()
+{
+}
+
+void NullRenderBackend::exit()
+{
+    _meshes.clear();
+}
+
+RenderBackend::MeshHandle NullRenderBackend::create_mesh(std::span<const SimpleVertex> vertices)
+{
+    _meshes.emplace_back(vertices.begin(), vertices.end());
+    return static_cast<MeshHandle>(_meshes.size() - 1);
+}
+
+void NullRenderBackend::begin_frame()
+{
+    if (_in_frame)
+    {
+        throw std::logic_error("NullRenderBackend: begin_frame called twice");
+    }
+
+    _in_frame = true;
+    _current_frame.clear();
+}
+
+void NullRenderBackend::upload_constants(const mat4f& world_view_proj)
+{
+    _constants = world_view_proj;
+}
+
+void NullRenderBackend::draw(const DrawCall& draw_call)
+{
+    if (!_in_frame)
+    {
+        throw std::logic_error("NullRenderBackend: draw called outside of a frame");
+    }
+
+    // written so that a huge start or count can't wrap around
+    const std::size_t size = get_mesh(draw_call.mesh).size();
+    if (draw_call.start_vertex > size || draw_call.vertex_count > size - draw_call.start_vertex)
+    {
+        throw std::out_of_range("NullRenderBackend: draw exceeds the mesh");
+    }
+
+    _current_frame.push_back({ draw_call, _constants });
+}
+
+void NullRenderBackend::end_frame()
+{
+    if (!_in_frame)
+    {
+        throw std::logic_error("NullRenderBackend: end_frame called without begin_frame");
+    }
+
+    _in_frame = false;
+
+    _last_frame_lists.assign(_recorder.get_max_lists(), {});
+    const uint32_t list_count = _recorder.record(_current_frame.size(), [this](const ParallelRecorder::Range& range)
+    {
+        _last_frame_lists[range.list_index] = { JobSystem::get_current_thread_index(), range.first, range.count };
+    });
+    _last_frame_lists.resize(list_count);
+
+    _total_draw_count += _current_frame.size();
+    _frame_count++;
+    std::swap(_last_frame, _current_frame);
+}
+
+uint64_t NullRenderBackend::get_frame_count() const
+{
+    return _frame_count;
+}
+
+uint64_t NullRenderBackend::get_total_draw_count() const
+{
+    return _total_draw_count;
+}
+
+const std::vector<NullRenderBackend::RecordedDraw>& NullRenderBackend::get_last_frame() const
+{
+    return _last_frame;
+}
+
+const std::vector<NullRenderBackend::RecordedList>& NullRenderBackend::get_last_frame_lists() const
+{
+    return _last_frame_lists;
+}
+
+std::span<const SimpleVertex> NullRenderBackend::get_mesh(MeshHandle mesh) const
+{
+    return _meshes.at(mesh);
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+#include "ParallelRecorder.hpp"
+#include "RenderBackend.hpp"
+
+// Renders nothing, but records everything that is submitted. Runs without window and gpu,
+// e.g. for headless throughput benchmarks of the frame loop or to inspect what a scene submits.
+// end_frame splits the draws into lists like the d3d12 backend and records which thread got which draws.
+class NullRenderBackend : public RenderBackend
+{
+public:
+	struct RecordedDraw
+	{
+		DrawCall draw_call;
+		mat4f world_view_proj;
+	};
+
+	// a command list that would have been recorded
+	struct RecordedList
+	{
+		uint32_t thread_index;
+		std::size_t first_draw;
+		std::size_t draw_count;
+	};
+
+	explicit NullRenderBackend(JobSystem* job_system = nullptr);
+
+	void initialize() override;
+	void exit() override;
+
+	MeshHandle create_mesh(std::span<const SimpleVertex> vertices) override;
+
+	void begin_frame() override;
+	void upload_constants(const mat4f& world_view_proj) override;
+	void draw(const DrawCall& draw_call) override;
+	void end_frame() override;
+
+	uint64_t get_frame_count() const;
+	uint64_t get_total_draw_count() const;
+	// draws of the last completed frame
+	const std::vector<RecordedDraw>& get_last_frame() const;
+	// lists of the last completed frame in submission order
+	const std::vector<RecordedList>& get_last_frame_lists() const;
+	std::span<const SimpleVertex> get_mesh(MeshHandle mesh) const;
+
+private:
+	std::vector<std::vector<SimpleVertex> > _meshes;
+
+	bool _in_frame;
+	mat4f _constants;
+	std::vector<RecordedDraw> _current_frame;
+	std::vector<RecordedDraw> _last_frame;
+	std::vector<RecordedList> _last_frame_lists;
+
+	ParallelRecorder _recorder;
+
+	uint64_t _frame_count;
+	uint64_t _total_draw_count;
+};
\ No newline at end of file
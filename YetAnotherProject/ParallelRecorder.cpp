@@ -0,0 +1,42 @@
+#include "ParallelRecorder.hpp"
+
+#include <algorithm>
+
+ParallelRecorder::ParallelRecorder(JobSystem* job_system, uint32_t max_lists, std::size_t min_draws_per_list)
+    : _job_system(job_system),
+    _max_lists(max_lists != 0 ? max_lists : (job_system ? job_system->get_thread_count() : 1)),
+    _min_draws_per_list(std::max<std::size_t>(1, min_draws_per_list))
+{
+}
+
+std::vector<ParallelRecorder::Range> ParallelRecorder::partition(std::size_t draw_count, uint32_t max_lists, std::size_t min_draws_per_list)
+{
+    std::vector<Range> ranges;
+    if (draw_count == 0)
+    {
+        return ranges;
+    }
+
+    min_draws_per_list = std::max<std::size_t>(1, min_draws_per_list);
+    const std::size_t list_count = std::clamp<std::size_t>(draw_count / min_draws_per_list, 1, std::max(1u, max_lists));
+
+    // the first draw_count % list_count lists get one more draw
+    const std::size_t base = draw_count / list_count;
+    const std::size_t remainder = draw_count % list_count;
+
+    ranges.reserve(list_count);
+    std::size_t first = 0;
+    for (std::size_t i = 0; i < list_count; ++i)
+    {
+        const std::size_t count = base + (i < remainder ? 1 : 0);
+        ranges.push_back({ static_cast<uint32_t>(i), first, count });
+        first += count;
+    }
+
+    return ranges;
+}
+
+uint32_t ParallelRecorder::get_max_lists() const
+{
+    return _max_lists;
+}
\ No newline at end of file
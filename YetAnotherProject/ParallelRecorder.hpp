@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "JobSystem.hpp"
+
+// Splits the draws of a frame into contiguous ranges, one per command list, and records the lists
+// in parallel on the job system. Every list index is recorded by exactly one thread per frame, so a
+// backend can keep one command list plus one allocator per frame for every list index without locking.
+// The lists have to be submitted in list index order to keep the draw order.
+class ParallelRecorder
+{
+public:
+    // below this many draws per list the recording is cheaper than the extra list
+    static const std::size_t default_min_draws_per_list = 64;
+
+    struct Range
+    {
+        uint32_t list_index;
+        std::size_t first;
+        std::size_t count;
+    };
+
+    // max_lists 0 uses one list per thread of the job system (or a single list without one)
+    ParallelRecorder(JobSystem* job_system, uint32_t max_lists = 0, std::size_t min_draws_per_list = default_min_draws_per_list);
+
+    // Evenly sized ranges covering [0, draw_count), at most max_lists and at least min_draws_per_list draws each
+    // (except when there are fewer draws in total). Empty for draw_count 0.
+    static std::vector<Range> partition(std::size_t draw_count, uint32_t max_lists, std::size_t min_draws_per_list);
+
+    // Calls record_list(range) for every range, in parallel if there is a job system.
+    // Returns the number of lists that have been recorded.
+    template <typename RecordFn>
+    uint32_t record(std::size_t draw_count, const RecordFn& record_list) const
+    {
+        const auto ranges = partition(draw_count, _max_lists, _min_draws_per_list);
+
+        if (_job_system && ranges.size() > 1)
+        {
+            _job_system->parallel_for(0, ranges.size(), 1, [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t i = first; i < last; ++i)
+                {
+                    record_list(ranges[i]);
+                }
+            });
+        }
+        else
+        {
+            for (const auto& range : ranges)
+            {
+                record_list(range);
+            }
+        }
+
+        return static_cast<uint32_t>(ranges.size());
+    }
+
+    uint32_t get_max_lists() const;
+
+private:
+    JobSystem* _job_system;
+    uint32_t _max_lists;
+    std::size_t _min_draws_per_list;
+};
\ No newline at end of file
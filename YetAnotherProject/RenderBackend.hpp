@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "mat4.hpp"
+#include "Vertex.hpp"
+
+// Backend independent rendering interface, implemented by the d3d12 GraphicContext and by backends
+// that don't need a window or gpu. A frame is recorded as begin_frame, any number of
+// upload_constants / draw calls and end_frame, which submits (and presents) the frame.
+class RenderBackend
+{
+public:
+	using MeshHandle = uint32_t;
+
+	struct DrawCall
+	{
+		MeshHandle mesh;
+		uint32_t vertex_count;
+		uint32_t start_vertex;
+	};
+
+	virtual ~RenderBackend() = default;
+
+	virtual void initialize() = 0;
+	virtual void exit() = 0;
+
+	// Uploads static geometry (triangle list), the returned handle is referenced by draw calls.
+	virtual MeshHandle create_mesh(std::span<const SimpleVertex> vertices) = 0;
+
+	virtual void begin_frame() = 0;
+	// Sets the constants for the following draw calls.
+	virtual void upload_constants(const mat4f& world_view_proj) = 0;
+	virtual void draw(const DrawCall& draw_call) = 0;
+	virtual void end_frame() = 0;
+};
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "RootSignatureLayout.hpp"
+
+#include <utility>
+
+namespace {
+    // registers a parameter occupies in one register class (b, t, u, s) and space
+    struct Binding
+    {
+        RootSignatureLayout::DescriptorType type;
+        uint32_t space;
+        uint64_t first;
+        uint64_t last;
+        RootSignatureLayout::Visibility visibility;
+        std::size_t parameter;
+    };
+
+    const char* register_prefix(RootSignatureLayout::DescriptorType type)
+    {
+        switch (type)
+        {
+        case RootSignatureLayout::DescriptorType::cbv: return "b";
+        case RootSignatureLayout::DescriptorType::srv: return "t";
+        case RootSignatureLayout::DescriptorType::uav: return "u";
+        default: return "s";
+        }
+    }
+
+    bool visible_to_same_stage(RootSignatureLayout::Visibility a, RootSignatureLayout::Visibility b)
+    {
+        return a == b || a == RootSignatureLayout::Visibility::all || b == RootSignatureLayout::Visibility::all;
+    }
+}
+
+uint32_t RootSignatureLayout::add_constants(uint32_t constant_count, uint32_t shader_register, uint32_t space, Visibility visibility)
+{
+    Parameter parameter = {};
+    parameter.type = ParameterType::constants;
+    parameter.visibility = visibility;
+    parameter.shader_register = shader_register;
+    parameter.space = space;
+    parameter.constant_count = constant_count;
+    parameter.descriptor_type = DescriptorType::cbv;
+    _parameters.push_back(std::move(parameter));
+    return static_cast<uint32_t>(_parameters.size() - 1);
+}
+
+uint32_t RootSignatureLayout::add_descriptor(DescriptorType type, uint32_t shader_register, uint32_t space, Visibility visibility)
+{
+    Parameter parameter = {};
+    parameter.type = ParameterType::descriptor;
+    parameter.visibility = visibility;
+    parameter.shader_register = shader_register;
+    parameter.space = space;
+    parameter.descriptor_type = type;
+    _parameters.push_back(std::move(parameter));
+    return static_cast<uint32_t>(_parameters.size() - 1);
+}
+
+uint32_t RootSignatureLayout::add_table(std::vector<Range> ranges, Visibility visibility)
+{
+    Parameter parameter = {};
+    parameter.type = ParameterType::table;
+    parameter.visibility = visibility;
+    parameter.ranges = std::move(ranges);
+    _parameters.push_back(std::move(parameter));
+    return static_cast<uint32_t>(_parameters.size() - 1);
+}
+
+RootSignatureLayout& RootSignatureLayout::allow_input_layout(bool allow)
+{
+    _allow_input_layout = allow;
+    return *this;
+}
+
+const std::vector<RootSignatureLayout::Parameter>& RootSignatureLayout::get_parameters() const
+{
+    return _parameters;
+}
+
+bool RootSignatureLayout::get_allow_input_layout() const
+{
+    return _allow_input_layout;
+}
+
+uint32_t RootSignatureLayout::get_size_in_dwords() const
+{
+    uint64_t size = 0;
+    for (const auto& parameter : _parameters)
+    {
+        switch (parameter.type)
+        {
+        case ParameterType::constants: size += parameter.constant_count; break;
+        case ParameterType::descriptor: size += 2; break;
+        case ParameterType::table: size += 1; break;
+        }
+    }
+    return size > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(size);
+}
+
+std::vector<std::string> RootSignatureLayout::validate() const
+{
+    std::vector<std::string> errors;
+    std::vector<Binding> bindings;
+
+    const uint32_t size = get_size_in_dwords();
+    if (size > max_size_in_dwords)
+    {
+        errors.push_back("root signature uses " + std::to_string(size) + " dwords, at most 64 are possible");
+    }
+
+    for (std::size_t p = 0; p < _parameters.size(); p++)
+    {
+        const Parameter& parameter = _parameters[p];
+        const std::string name = "parameter " + std::to_string(p);
+
+        switch (parameter.type)
+        {
+        case ParameterType::constants:
+            if (parameter.constant_count == 0)
+            {
+                errors.push_back(name + ": root constants without values");
+            }
+            bindings.push_back({ DescriptorType::cbv, parameter.space, parameter.shader_register, parameter.shader_register + 1ull, parameter.visibility, p });
+            break;
+
+        case ParameterType::descriptor:
+            if (parameter.descriptor_type == DescriptorType::sampler)
+            {
+                errors.push_back(name + ": samplers can only be bound through tables");
+            }
+            bindings.push_back({ parameter.descriptor_type, parameter.space, parameter.shader_register, parameter.shader_register + 1ull, parameter.visibility, p });
+            break;
+
+        case ParameterType::table:
+        {
+            if (parameter.ranges.empty())
+            {
+                errors.push_back(name + ": table without ranges");
+            }
+
+            bool has_samplers = false;
+            bool has_views = false;
+            for (std::size_t r = 0; r < parameter.ranges.size(); r++)
+            {
+                const Range& range = parameter.ranges[r];
+                (range.type == DescriptorType::sampler ? has_samplers : has_views) = true;
+
+                if (range.count == 0)
+                {
+                    errors.push_back(name + ": empty range " + std::to_string(r));
+                    continue;
+                }
+                if (range.count == unbounded && r + 1 != parameter.ranges.size())
+                {
+                    errors.push_back(name + ": only the last range of a table may be unbounded");
+                }
+
+                const uint64_t last = range.count == unbounded ? UINT32_MAX + 1ull : range.base_register + static_cast<uint64_t>(range.count);
+                bindings.push_back({ range.type, range.space, range.base_register, last, parameter.visibility, p });
+            }
+
+            if (has_samplers && has_views)
+            {
+                errors.push_back(name + ": samplers and views can't share a table, they live in different heaps");
+            }
+            break;
+        }
+        }
+    }
+
+    for (std::size_t i = 0; i < bindings.size(); i++)
+    {
+        for (std::size_t j = i + 1; j < bindings.size(); j++)
+        {
+            const Binding& a = bindings[i];
+            const Binding& b = bindings[j];
+            if (a.type == b.type && a.space == b.space && visible_to_same_stage(a.visibility, b.visibility) && a.first < b.last && b.first < a.last)
+            {
+                const uint64_t overlap = a.first > b.first ? a.first : b.first;
+                errors.push_back("parameters " + std::to_string(a.parameter) + " and " + std::to_string(b.parameter) + " both bind "
+                    + register_prefix(a.type) + std::to_string(overlap) + ", space " + std::to_string(a.space));
+            }
+        }
+    }
+
+    return errors;
+}
+
+bool RootSignatureLayout::is_valid() const
+{
+    return validate().empty();
+}
+
+RootSignatureLayout RootSignatureLayout::default_layout()
+{
+    RootSignatureLayout layout;
+    layout.add_descriptor(DescriptorType::cbv, 0, 0, Visibility::vertex);
+    layout.allow_input_layout();
+    return layout;
+}
+
+RootSignatureLayout RootSignatureLayout::table_layout()
+{
+    RootSignatureLayout layout;
+    layout.add_table({ { DescriptorType::cbv, 1, 0, 0 } }, Visibility::vertex);
+    layout.allow_input_layout();
+    return layout;
+}
\ No newline at end of file
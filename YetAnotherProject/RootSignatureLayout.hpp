@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Backend independent description of a root signature, turned into a d3d12 one by create_root_signature.
+// The parameter order is the binding order, add_* return the index to bind a parameter with.
+// Cheapest per draw binding first:
+// - root constants: the values live in the command list itself, no memory indirection
+// - root descriptors (cbv/srv/uav): a gpu address, e.g. of an UploadAllocator allocation
+// - descriptor tables: a range of a DescriptorHeap, for many or typed views (textures, samplers)
+class RootSignatureLayout
+{
+public:
+    // d3d12 limit of a root signature, constants cost one dword each, root descriptors two, tables one
+    static const uint32_t max_size_in_dwords = 64;
+    // descriptor count of a range that extends to the end of the heap
+    static const uint32_t unbounded = UINT32_MAX;
+
+    enum class Visibility { all, vertex, pixel };
+    enum class DescriptorType { cbv, srv, uav, sampler };
+    enum class ParameterType { constants, descriptor, table };
+
+    struct Range
+    {
+        DescriptorType type;
+        uint32_t count;
+        uint32_t base_register;
+        uint32_t space;
+    };
+
+    struct Parameter
+    {
+        ParameterType type;
+        Visibility visibility;
+        // constants and descriptor
+        uint32_t shader_register;
+        uint32_t space;
+        // constants only
+        uint32_t constant_count;
+        // descriptor only
+        DescriptorType descriptor_type;
+        // table only
+        std::vector<Range> ranges;
+    };
+
+    // count 32 bit values bound to register b<shader_register>
+    uint32_t add_constants(uint32_t constant_count, uint32_t shader_register, uint32_t space = 0, Visibility visibility = Visibility::all);
+    // a single root cbv/srv/uav, samplers are only possible in tables
+    uint32_t add_descriptor(DescriptorType type, uint32_t shader_register, uint32_t space = 0, Visibility visibility = Visibility::all);
+    uint32_t add_table(std::vector<Range> ranges, Visibility visibility = Visibility::all);
+    RootSignatureLayout& allow_input_layout(bool allow = true);
+
+    const std::vector<Parameter>& get_parameters() const;
+    bool get_allow_input_layout() const;
+    uint32_t get_size_in_dwords() const;
+
+    // Describes every problem of the layout (size limit, empty or mixed tables, overlapping registers, ...),
+    // empty if the layout is valid.
+    std::vector<std::string> validate() const;
+    bool is_valid() const;
+
+    // per draw constants as root cbv at b0 for the vertex shader, used by the GraphicContext
+    static RootSignatureLayout default_layout();
+    // the same constants through a single cbv table, one descriptor write and table bind per change
+    static RootSignatureLayout table_layout();
+
+private:
+    std::vector<Parameter> _parameters;
+    bool _allow_input_layout = false;
+};
\ No newline at end of file
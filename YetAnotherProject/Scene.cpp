@@ -0,0 +1,85 @@
+#include "Scene.hpp"
+
+#include "utility.hpp"
+
+namespace {
+    constexpr float g_fov = util::math::pi() * 0.75f;
+    constexpr float g_aspect = 800.0f / 600.0f;
+    constexpr float g_near_z = 0.1f;
+    constexpr float g_far_z = 10.0f;
+
+    constexpr vec3f g_eye = vec3f(4.0f, 3.0f, -3.0f);
+    constexpr vec3f g_at = vec3f(0.0f, 0.0f, 0.0f);
+    constexpr vec3f g_up = vec3f(0.0f, 1.0f, 0.0f);
+
+    constexpr float g_z_val = 0.5f;
+    const SimpleVertex g_triangle_vertices[] =
+    {
+        { { 0.0f, 5.0f, g_z_val }, { 1.0f, 0.0f, 0.0f, 1.0f } },
+        { { 5.0f, -5.0f, g_z_val }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+        { { -5.0f, -5.0f, g_z_val }, { 0.0f, 0.0f, 1.0f, 1.0f } }
+    };
+}
+
+Scene::Scene()
+    : _triangle(0),
+    // look_at and proj need sqrt / trigonometry and can't be folded, but the camera is static so compose it once
+    _view_proj(mat::proj(g_fov, g_aspect, g_near_z, g_far_z) * mat::look_at(g_eye, g_at, g_up)),
+    _frustum(cull::extract_frustum(_view_proj)),
+    _time(0.0)
+{
+}
+
+void Scene::initialize(RenderBackend& backend)
+{
+    _triangle = backend.create_mesh(g_triangle_vertices);
+
+    const Entity triangle = _entities.create();
+    _entities.set_draw_call(triangle, { _triangle, 3, 0 });
+    _entities.set_local_bounds(triangle, vec3f(0.0f, 0.0f, g_z_val), vec3f(5.0f, 5.0f, 0.0f));
+    _entities.update_world();
+}
+
+void Scene::update(double elapsed_seconds)
+{
+    _time += elapsed_seconds;
+    _entities.update_world();
+}
+
+void Scene::render(RenderBackend& backend) const
+{
+    _visible.resize(_entities.size());
+    const std::size_t visible_count = cull::cull_aabbs(_frustum, _entities.get_world_bounds(), _visible);
+
+    const auto world_matrices = _entities.get_world_matrices();
+    const auto draw_calls = _entities.get_draw_calls();
+
+    backend.begin_frame();
+    for (std::size_t i = 0; i < visible_count; ++i)
+    {
+        const uint32_t entity = _visible[i];
+        if (draw_calls[entity].vertex_count == 0)
+        {
+            continue;
+        }
+
+        backend.upload_constants(_view_proj * world_matrices[entity]);
+        backend.draw(draw_calls[entity]);
+    }
+    backend.end_frame();
+}
+
+EntityStore& Scene::get_entities()
+{
+    return _entities;
+}
+
+const EntityStore& Scene::get_entities() const
+{
+    return _entities;
+}
+
+double Scene::get_time() const
+{
+    return _time;
+}
\ No newline at end of file
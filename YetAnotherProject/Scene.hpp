@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "EntityStore.hpp"
+#include "frustum.hpp"
+#include "mat4.hpp"
+#include "RenderBackend.hpp"
+
+// Everything that is simulated and drawn, independent of the backend it is drawn with.
+class Scene
+{
+public:
+	Scene();
+
+	// creates the meshes, the backend has to be initialized
+	void initialize(RenderBackend& backend);
+	// advances the simulation by one (fixed) step
+	void update(double elapsed_seconds);
+	// draws the entities inside the view frustum
+	void render(RenderBackend& backend) const;
+
+	EntityStore& get_entities();
+	const EntityStore& get_entities() const;
+
+	double get_time() const;
+
+private:
+	RenderBackend::MeshHandle _triangle;
+	mat4f _view_proj;
+	cull::frustum _frustum;
+	EntityStore _entities;
+	// dense indices of the visible entities, scratch memory of render
+	mutable std::vector<uint32_t> _visible;
+	double _time;
+};
\ No newline at end of file
@@ -79,7 +79,7 @@ void SimpleCamera::reset()
     _pos = _initial_pos;
     _yaw = util::math::pi();
     _pitch = 0.0f;
-    _look_dir = { 0, 0, -1 };
+    update_orientation();
 }
 
 void SimpleCamera::update(float frametime)
@@ -106,6 +106,8 @@ void SimpleCamera::update(float frametime)
     float moveInterval = _move_speed * frametime;
     float rotateInterval = _move_speed * frametime;
 
+    const bool rotated = _pressed_keys.left || _pressed_keys.right || _pressed_keys.up || _pressed_keys.down;
+
     if (_pressed_keys.left)
         _yaw += rotateInterval;
     if (_pressed_keys.right)
@@ -120,20 +122,31 @@ void SimpleCamera::update(float frametime)
     _pitch = std::min(_pitch, util::math::pi4());
     _pitch = std::max(-util::math::pi4(), _pitch);
 
+    if (rotated)
+        update_orientation();
+
     // Move the camera in model space.
-    float x = move.x * -cosf(_yaw) - move.z * sinf(_yaw);
-    float z = move.x * sinf(_yaw) - move.z * cosf(_yaw);
-    _pos.x += x * moveInterval;
-    _pos.z += z * moveInterval;
+    const vec3f world_move = -quat::rotate(_yaw_rotation, move);
+    _pos.x += world_move.x * moveInterval;
+    _pos.z += world_move.z * moveInterval;
+}
+
+void SimpleCamera::update_orientation()
+{
+    // yaw around the up axis, pitch around the camera's x axis (positive pitch looks up)
+    _yaw_rotation = quat::from_axis_angle(_up_vec, _yaw);
+    _orientation = _yaw_rotation * quat::from_axis_angle(vec3f(1.0f, 0.0f, 0.0f), -_pitch);
 
     // Determine the look direction.
-    float r = cosf(_pitch);
-    _look_dir.x = r * sinf(_yaw);
-    _look_dir.y = sinf(_pitch);
-    _look_dir.z = r * cosf(_yaw);
+    _look_dir = quat::rotate(_orientation, vec3f(0.0f, 0.0f, 1.0f));
 }
 
 mat4f SimpleCamera::get_view() const
 {
     return mat::look_to(_pos, _look_dir, _up_vec);
+}
+
+const quatf& SimpleCamera::get_orientation() const
+{
+    return _orientation;
 }
\ No newline at end of file
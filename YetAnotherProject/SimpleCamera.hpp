@@ -5,6 +5,7 @@
 #include <algorithm>
 #include "vec.hpp"
 #include "mat4.hpp"
+#include "quat.hpp"
 
 class SimpleCamera
 {
@@ -16,6 +17,7 @@ public:
 	void reset();
 	void update(float frametime);
 	mat4f get_view() const;
+	const quatf& get_orientation() const;
 
 private:
 	struct PressedKeys
@@ -43,6 +45,11 @@ private:
 	vec3f _look_dir;
 	float _pitch;
 	float _yaw;
+	// only rebuilt when pitch or yaw change, the movement only depends on the yaw
+	quatf _yaw_rotation;
+	quatf _orientation;
 
 	const vec3f _up_vec;
+
+	void update_orientation();
 };
\ No newline at end of file
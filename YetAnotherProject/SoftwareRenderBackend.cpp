@@ -0,0 +1,380 @@
+#include "SoftwareRenderBackend.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+#include "simd.hpp"
+
+namespace {
+    constexpr float g_clear_color[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+
+    uint32_t pack_rgba8(float r, float g, float b, float a)
+    {
+        auto to_unorm8 = [](float f) { return static_cast<uint32_t>(std::clamp(f, 0.0f, 1.0f) * 255.0f + 0.5f); };
+        return to_unorm8(r) | (to_unorm8(g) << 8) | (to_unorm8(b) << 16) | (to_unorm8(a) << 24);
+    }
+}
+
+SoftwareRenderBackend::SoftwareRenderBackend(uint32_t width, uint32_t height, JobSystem* job_system)
+    : _width(width),
+    _height(height),
+    _job_system(job_system),
+    _tiles_x((width + tile_size - 1) / tile_size),
+    _tiles_y((height + tile_size - 1) / tile_size),
+    _world_view_proj(mat::identity()),
+    _frame_stats(),
+    _stats()
+{
+}
+
+void SoftwareRenderBackend::initialize()
+{
+    _color_buffer.assign(static_cast<std::size_t>(_width) * _height, pack_rgba8(g_clear_color[0], g_clear_color[1], g_clear_color[2], g_clear_color[3]));
+    _depth_buffer.assign(static_cast<std::size_t>(_width) * _height, 1.0f);
+    _bins.resize(static_cast<std::size_t>(_tiles_x) * _tiles_y);
+}
+
+void SoftwareRenderBackend::exit()
+{
+    _meshes.clear();
+}
+
+RenderBackend::MeshHandle SoftwareRenderBackend::create_mesh(std::span<const SimpleVertex> vertices)
+{
+    _meshes.emplace_back(vertices.begin(), vertices.end());
+    return static_cast<MeshHandle>(_meshes.size() - 1);
+}
+
+void SoftwareRenderBackend::begin_frame()
+{
+    _triangles.clear();
+    for (auto& bin : _bins)
+    {
+        bin.clear();
+    }
+
+    _frame_stats = Stats();
+}
+
+void SoftwareRenderBackend::upload_constants(const mat4f& world_view_proj)
+{
+    _world_view_proj = world_view_proj;
+}
+
+void SoftwareRenderBackend::draw(const DrawCall& draw_call)
+{
+    const auto& mesh = _meshes.at(draw_call.mesh);
+    // written so that a huge start or count can't wrap around
+    if (draw_call.start_vertex > mesh.size() || draw_call.vertex_count > mesh.size() - draw_call.start_vertex)
+    {
+        throw std::out_of_range("SoftwareRenderBackend: draw exceeds the mesh");
+    }
+
+    const std::span<const SimpleVertex> vertices(mesh.data() + draw_call.start_vertex, draw_call.vertex_count);
+    _clip_positions.resize(vertices.size());
+    mat::transform(_world_view_proj, vertices, _clip_positions);
+
+    for (std::size_t i = 0; i + 3 <= vertices.size(); i += 3)
+    {
+        _frame_stats.triangles_submitted++;
+        clip_triangle(
+            { _clip_positions[i + 0], vertices[i + 0].color },
+            { _clip_positions[i + 1], vertices[i + 1].color },
+            { _clip_positions[i + 2], vertices[i + 2].color });
+    }
+}
+
+void SoftwareRenderBackend::end_frame()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // tiles don't share pixels, so they can be rasterized in any order on any thread
+    const uint32_t tile_count = _tiles_x * _tiles_y;
+    auto rasterize_tiles = [this](std::size_t first, std::size_t last)
+    {
+        for (std::size_t tile = first; tile < last; ++tile)
+        {
+            rasterize_tile(static_cast<uint32_t>(tile));
+        }
+    };
+
+    if (_job_system)
+    {
+        _job_system->parallel_for(0, tile_count, 1, rasterize_tiles);
+    }
+    else
+    {
+        rasterize_tiles(0, tile_count);
+    }
+
+    _frame_stats.raster_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    _stats = _frame_stats;
+}
+
+uint32_t SoftwareRenderBackend::get_width() const
+{
+    return _width;
+}
+
+uint32_t SoftwareRenderBackend::get_height() const
+{
+    return _height;
+}
+
+uint32_t SoftwareRenderBackend::get_thread_count() const
+{
+    return _job_system ? _job_system->get_thread_count() : 1;
+}
+
+std::span<const uint32_t> SoftwareRenderBackend::get_color_buffer() const
+{
+    return _color_buffer;
+}
+
+std::span<const float> SoftwareRenderBackend::get_depth_buffer() const
+{
+    return _depth_buffer;
+}
+
+const SoftwareRenderBackend::Stats& SoftwareRenderBackend::get_stats() const
+{
+    return _stats;
+}
+
+void SoftwareRenderBackend::clip_triangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2)
+{
+    // d3d clip space, only the near plane z >= 0 has to be clipped. Everything else is handled by
+    // the screen bounds of the triangle and the depth test.
+    const ClipVertex* in[3] = { &v0, &v1, &v2 };
+    const int inside_count = (v0.pos.z >= 0.0f) + (v1.pos.z >= 0.0f) + (v2.pos.z >= 0.0f);
+
+    if (inside_count == 3)
+    {
+        setup_triangle(v0, v1, v2);
+        return;
+    }
+
+    if (inside_count == 0)
+    {
+        _frame_stats.triangles_culled++;
+        return;
+    }
+
+    // clipping one plane leaves a triangle or a quad
+    ClipVertex polygon[4];
+    int count = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        const ClipVertex& a = *in[i];
+        const ClipVertex& b = *in[(i + 1) % 3];
+
+        if (a.pos.z >= 0.0f)
+        {
+            polygon[count++] = a;
+        }
+
+        if ((a.pos.z >= 0.0f) != (b.pos.z >= 0.0f))
+        {
+            const float t = a.pos.z / (a.pos.z - b.pos.z);
+            polygon[count++] = { a.pos + (b.pos - a.pos) * t, a.color + (b.color - a.color) * t };
+        }
+    }
+
+    for (int i = 1; i + 1 < count; ++i)
+    {
+        setup_triangle(polygon[0], polygon[i], polygon[i + 1]);
+    }
+}
+
+void SoftwareRenderBackend::setup_triangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2)
+{
+    const ClipVertex* v[3] = { &v0, &v1, &v2 };
+
+    Triangle tri;
+    float x[3];
+    float y[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        if (v[i]->pos.w <= 0.0f)
+        {
+            _frame_stats.triangles_culled++;
+            return;
+        }
+
+        tri.inv_w[i] = 1.0f / v[i]->pos.w;
+        x[i] = (v[i]->pos.x * tri.inv_w[i] + 1.0f) * 0.5f * static_cast<float>(_width);
+        y[i] = (1.0f - v[i]->pos.y * tri.inv_w[i]) * 0.5f * static_cast<float>(_height);
+        tri.z[i] = v[i]->pos.z * tri.inv_w[i];
+        for (int c = 0; c < 4; ++c)
+        {
+            tri.color_over_w[i][c] = v[i]->color[c] * tri.inv_w[i];
+        }
+    }
+
+    // y points down on screen, so clockwise triangles have a positive area
+    const float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (!(area > 0.0f))
+    {
+        _frame_stats.triangles_culled++;
+        return;
+    }
+
+    const float min_x = std::max(0.0f, std::floor(std::min({ x[0], x[1], x[2] })));
+    const float min_y = std::max(0.0f, std::floor(std::min({ y[0], y[1], y[2] })));
+    const float max_x = std::min(static_cast<float>(_width - 1), std::ceil(std::max({ x[0], x[1], x[2] })));
+    const float max_y = std::min(static_cast<float>(_height - 1), std::ceil(std::max({ y[0], y[1], y[2] })));
+    if (min_x > max_x || min_y > max_y)
+    {
+        _frame_stats.triangles_culled++;
+        return;
+    }
+
+    tri.min_x = static_cast<int32_t>(min_x);
+    tri.min_y = static_cast<int32_t>(min_y);
+    tri.max_x = static_cast<int32_t>(max_x);
+    tri.max_y = static_cast<int32_t>(max_y);
+    tri.inv_area = 1.0f / area;
+
+    for (int e = 0; e < 3; ++e)
+    {
+        const int i = (e + 1) % 3;
+        const int j = (e + 2) % 3;
+        tri.edge_a[e] = y[i] - y[j];
+        tri.edge_b[e] = x[j] - x[i];
+        tri.edge_c[e] = -(tri.edge_a[e] * x[i] + tri.edge_b[e] * y[i]);
+        tri.edge_inclusive[e] = tri.edge_a[e] > 0.0f || (tri.edge_a[e] == 0.0f && tri.edge_b[e] > 0.0f);
+    }
+
+    const auto index = static_cast<uint32_t>(_triangles.size());
+    _triangles.push_back(tri);
+    _frame_stats.triangles_binned++;
+
+    for (uint32_t ty = tri.min_y / tile_size; ty <= tri.max_y / tile_size; ++ty)
+    {
+        for (uint32_t tx = tri.min_x / tile_size; tx <= tri.max_x / tile_size; ++tx)
+        {
+            _bins[ty * _tiles_x + tx].push_back(index);
+            _frame_stats.tile_triangle_pairs++;
+        }
+    }
+}
+
+void SoftwareRenderBackend::rasterize_tile(uint32_t tile_index)
+{
+    const int32_t tile_x0 = static_cast<int32_t>((tile_index % _tiles_x) * tile_size);
+    const int32_t tile_y0 = static_cast<int32_t>((tile_index / _tiles_x) * tile_size);
+    const int32_t tile_x1 = std::min(tile_x0 + static_cast<int32_t>(tile_size), static_cast<int32_t>(_width));
+    const int32_t tile_y1 = std::min(tile_y0 + static_cast<int32_t>(tile_size), static_cast<int32_t>(_height));
+
+    const uint32_t clear_color = pack_rgba8(g_clear_color[0], g_clear_color[1], g_clear_color[2], g_clear_color[3]);
+    for (int32_t py = tile_y0; py < tile_y1; ++py)
+    {
+        const std::size_t row = static_cast<std::size_t>(py) * _width;
+        std::fill(_color_buffer.begin() + row + tile_x0, _color_buffer.begin() + row + tile_x1, clear_color);
+        std::fill(_depth_buffer.begin() + row + tile_x0, _depth_buffer.begin() + row + tile_x1, 1.0f);
+    }
+
+    const simd::float4 lane_offsets = simd::set(0.0f, 1.0f, 2.0f, 3.0f);
+    const simd::float4 zero = simd::set1(0.0f);
+    const simd::float4 one = simd::set1(1.0f);
+
+    for (const uint32_t index : _bins[tile_index])
+    {
+        const Triangle& tri = _triangles[index];
+
+        // tile_size is a multiple of 4, so aligning down never leaves the tile
+        const int32_t x0 = std::max(tri.min_x, tile_x0) & ~3;
+        const int32_t x1 = std::min(tri.max_x + 1, tile_x1);
+        const int32_t y0 = std::max(tri.min_y, tile_y0);
+        const int32_t y1 = std::min(tri.max_y + 1, tile_y1);
+        const simd::float4 x_end = simd::set1(static_cast<float>(x1));
+
+        simd::float4 edge_a[3], edge_b[3], edge_c[3];
+        for (int e = 0; e < 3; ++e)
+        {
+            edge_a[e] = simd::set1(tri.edge_a[e]);
+            edge_b[e] = simd::set1(tri.edge_b[e]);
+            edge_c[e] = simd::set1(tri.edge_c[e]);
+        }
+
+        for (int32_t py = y0; py < y1; ++py)
+        {
+            const simd::float4 center_y = simd::set1(static_cast<float>(py) + 0.5f);
+            simd::float4 edge_row[3];
+            for (int e = 0; e < 3; ++e)
+            {
+                edge_row[e] = edge_b[e] * center_y + edge_c[e];
+            }
+
+            const std::size_t row = static_cast<std::size_t>(py) * _width;
+            for (int32_t px = x0; px < x1; px += 4)
+            {
+                const simd::float4 pixel_x = simd::set1(static_cast<float>(px)) + lane_offsets;
+                const simd::float4 center_x = pixel_x + simd::set1(0.5f);
+
+                simd::float4 weights[3];
+                simd::float4 mask = pixel_x < x_end;
+                for (int e = 0; e < 3; ++e)
+                {
+                    weights[e] = edge_a[e] * center_x + edge_row[e];
+                    mask = mask & (tri.edge_inclusive[e] ? weights[e] >= zero : weights[e] > zero);
+                }
+
+                if (simd::mask_bits(mask) == 0)
+                {
+                    continue;
+                }
+
+                // depth is affine in screen space, the color has to be interpolated with 1 / w
+                const simd::float4 inv_area = simd::set1(tri.inv_area);
+                const simd::float4 b0 = weights[0] * inv_area;
+                const simd::float4 b1 = weights[1] * inv_area;
+                const simd::float4 b2 = weights[2] * inv_area;
+                const simd::float4 z = b0 * simd::set1(tri.z[0]) + b1 * simd::set1(tri.z[1]) + b2 * simd::set1(tri.z[2]);
+
+                // lanes past the right border of the framebuffer must not be touched, they belong to the next row
+                const bool full = px + 4 <= x1;
+                float depth[4];
+                if (full)
+                {
+                    simd::store(depth, simd::load(&_depth_buffer[row + px]));
+                }
+                else
+                {
+                    for (int32_t i = 0; i < 4; ++i)
+                    {
+                        depth[i] = px + i < x1 ? _depth_buffer[row + px + i] : 0.0f;
+                    }
+                }
+
+                mask = mask & (z < simd::load(depth)) & (z >= zero) & (z <= one);
+                const int bits = simd::mask_bits(mask);
+                if (bits == 0)
+                {
+                    continue;
+                }
+
+                const simd::float4 w = one / (b0 * simd::set1(tri.inv_w[0]) + b1 * simd::set1(tri.inv_w[1]) + b2 * simd::set1(tri.inv_w[2]));
+                float color[4][4];
+                for (int c = 0; c < 4; ++c)
+                {
+                    const simd::float4 color_over_w = b0 * simd::set1(tri.color_over_w[0][c]) + b1 * simd::set1(tri.color_over_w[1][c]) + b2 * simd::set1(tri.color_over_w[2][c]);
+                    simd::store(color[c], color_over_w * w);
+                }
+
+                float new_depth[4];
+                simd::store(new_depth, z);
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (bits & (1 << i))
+                    {
+                        _depth_buffer[row + px + i] = new_depth[i];
+                        _color_buffer[row + px + i] = pack_rgba8(color[0][i], color[1][i], color[2][i], color[3][i]);
+                    }
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
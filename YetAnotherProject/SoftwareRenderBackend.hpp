@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "JobSystem.hpp"
+#include "RenderBackend.hpp"
+
+// Cpu rasterizer, renders the same frames as the d3d12 backend without a gpu (thumbnails, image comparisons).
+// Draws are transformed, clipped against the near plane and binned into screen tiles, end_frame then
+// rasterizes the tiles in parallel on the job system. Follows the d3d12 defaults of the GraphicContext pipeline:
+// clockwise triangles are front facing and back faces are culled, plus a less depth test.
+class SoftwareRenderBackend : public RenderBackend
+{
+public:
+	static constexpr uint32_t tile_size = 32;
+
+	struct Stats
+	{
+		uint64_t triangles_submitted;
+		// back facing, degenerate or completely clipped
+		uint64_t triangles_culled;
+		uint64_t triangles_binned;
+		uint64_t tile_triangle_pairs;
+		// time spent in end_frame
+		double raster_seconds;
+	};
+
+	// without a job system the tiles are rasterized on the calling thread
+	SoftwareRenderBackend(uint32_t width, uint32_t height, JobSystem* job_system = nullptr);
+
+	void initialize() override;
+	void exit() override;
+
+	MeshHandle create_mesh(std::span<const SimpleVertex> vertices) override;
+
+	void begin_frame() override;
+	void upload_constants(const mat4f& world_view_proj) override;
+	void draw(const DrawCall& draw_call) override;
+	void end_frame() override;
+
+	uint32_t get_width() const;
+	uint32_t get_height() const;
+	uint32_t get_thread_count() const;
+	// RGBA8, one uint32_t per pixel with red in the lowest byte, rows top to bottom
+	std::span<const uint32_t> get_color_buffer() const;
+	std::span<const float> get_depth_buffer() const;
+	// stats of the last finished frame
+	const Stats& get_stats() const;
+
+private:
+	struct ClipVertex
+	{
+		vec4f pos;
+		vec4f color;
+	};
+
+	// screen space triangle with everything the tile rasterizer needs
+	struct Triangle
+	{
+		// edge functions e(x, y) = a * x + b * y + c, the edge opposite to vertex i has index i
+		float edge_a[3];
+		float edge_b[3];
+		float edge_c[3];
+		// top left fill rule, pixels exactly on the edge are only covered by top and left edges
+		bool edge_inclusive[3];
+		float inv_area;
+		float z[3];
+		float inv_w[3];
+		// color / w for perspective correct interpolation
+		float color_over_w[3][4];
+		int32_t min_x, min_y, max_x, max_y;
+	};
+
+	uint32_t _width;
+	uint32_t _height;
+	JobSystem* _job_system;
+	uint32_t _tiles_x;
+	uint32_t _tiles_y;
+
+	std::vector<std::vector<SimpleVertex> > _meshes;
+	mat4f _world_view_proj;
+
+	std::vector<Triangle> _triangles;
+	// triangle indices per tile in submission order
+	std::vector<std::vector<uint32_t> > _bins;
+
+	std::vector<uint32_t> _color_buffer;
+	std::vector<float> _depth_buffer;
+
+	std::vector<vec4f> _clip_positions;
+	Stats _frame_stats;
+	Stats _stats;
+
+	void setup_triangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2);
+	void clip_triangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2);
+	void rasterize_tile(uint32_t tile_index);
+};
\ No newline at end of file
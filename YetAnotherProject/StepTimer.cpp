@@ -1,56 +1,79 @@
 #include "StepTimer.hpp"
 
+#include <chrono>
 #include <cmath>
+#include <stdexcept>
+
+StepTimer::ClockSource StepTimer::steady_clock_source()
+{
+    using clock = std::chrono::steady_clock;
+    static_assert(clock::period::num == 1, "steady_clock period is expected to be a fraction of a second");
+
+    return ClockSource{
+        []() { return static_cast<uint64_t>(clock::now().time_since_epoch().count()); },
+        static_cast<uint64_t>(clock::period::den)
+    };
+}
 
 StepTimer::StepTimer()
-    : _elapsed_ticks(0),
+    : StepTimer(steady_clock_source())
+{
+}
+
+StepTimer::StepTimer(ClockSource clock_source)
+    : _clock(std::move(clock_source)),
+    _elapsed_ticks(0),
     _total_ticks(0),
     _left_over_ticks(0),
+    _frame_ticks(0),
     _frame_count(0),
     _frames_per_second(0),
     _frames_this_second(0),
-    _qpc_second_counter(0),
+    _clock_second_counter(0),
+    _is_fixed_time_step(true),
     _target_elapsed_ticks(ticks_per_second / 60)
 {
-    QueryPerformanceFrequency(&_qpc_frequency);
-    QueryPerformanceCounter(&_qpc_last_time);
-    _qpc_max_delta = _qpc_frequency.QuadPart / 10;
+    _clock_last_time = _clock.now();
+    _clock_max_delta = _clock.frequency / 10;
 }
 
 void StepTimer::reset_elapsed_time()
 {
-    QueryPerformanceCounter(&_qpc_last_time);
+    _clock_last_time = _clock.now();
 
     _left_over_ticks = 0;
     _frames_per_second = 0;
     _frames_this_second = 0;
-    _qpc_second_counter = 0;
+    _clock_second_counter = 0;
 }
 
-void StepTimer::tick()
+uint64_t StepTimer::query_time_delta()
 {
     // Query the current time.
-    LARGE_INTEGER currentTime;
-
-    QueryPerformanceCounter(&currentTime);
+    const uint64_t currentTime = _clock.now();
 
-    UINT64 timeDelta = currentTime.QuadPart - _qpc_last_time.QuadPart;
+    uint64_t timeDelta = currentTime - _clock_last_time;
 
-    _qpc_last_time = currentTime;
-    _qpc_second_counter += timeDelta;
+    _clock_last_time = currentTime;
+    _clock_second_counter += timeDelta;
+    _frame_stats.add_sample(static_cast<double>(timeDelta) / _clock.frequency);
 
     // Clamp excessively large time deltas (e.g. after paused in the debugger).
-    if (timeDelta > _qpc_max_delta)
+    if (timeDelta > _clock_max_delta)
     {
-        timeDelta = _qpc_max_delta;
+        timeDelta = _clock_max_delta;
     }
 
-    // Convert QPC units into a canonical tick format. This cannot overflow due to the previous clamp.
+    // Convert clock units into a canonical tick format. This cannot overflow due to the previous clamp.
     timeDelta *= ticks_per_second;
-    timeDelta /= _qpc_frequency.QuadPart;
+    timeDelta /= _clock.frequency;
 
-    UINT32 lastFrameCount = _frame_count;
+    _frame_ticks = timeDelta;
+    return timeDelta;
+}
 
+void StepTimer::accumulate_fixed_time(uint64_t timeDelta)
+{
     // Fixed timestep update logic
     // If the app is running very close to the target elapsed time (within 1/4 of a millisecond) just clamp
     // the clock to exactly match the target value. This prevents tiny and irrelevant errors
@@ -59,42 +82,117 @@ void StepTimer::tick()
     // accumulate enough tiny errors that it would drop a frame. It is better to just round 
     // small deviations down to zero to leave things running smoothly.
 
-    if (std::abs(static_cast<int>(timeDelta - _target_elapsed_ticks)) < ticks_per_second / 4000)
+    if (std::abs(static_cast<int64_t>(timeDelta - _target_elapsed_ticks)) < static_cast<int64_t>(ticks_per_second / 4000))
     {
         timeDelta = _target_elapsed_ticks;
     }
 
     _left_over_ticks += timeDelta;
+}
 
-    while (_left_over_ticks >= _target_elapsed_ticks)
-    {
-        _elapsed_ticks = _target_elapsed_ticks;
-        _total_ticks += _target_elapsed_ticks;
-        _left_over_ticks -= _target_elapsed_ticks;
-        _frame_count++;
-
-        // UPDATE here!
-        /*if (update)
-        {
-            update();
-        }*/
-    }
-
+void StepTimer::track_frame_rate(uint32_t lastFrameCount)
+{
     // Track the current framerate.
     if (_frame_count != lastFrameCount)
     {
         _frames_this_second++;
     }
 
-    if (_qpc_second_counter >= static_cast<UINT64>(_qpc_frequency.QuadPart))
+    if (_clock_second_counter >= _clock.frequency)
     {
         _frames_per_second = _frames_this_second;
         _frames_this_second = 0;
-        _qpc_second_counter %= _qpc_frequency.QuadPart;
+        _clock_second_counter %= _clock.frequency;
     }
 }
 
-UINT32 StepTimer::get_fps() const
+void StepTimer::tick()
+{
+    tick([]() {});
+}
+
+uint32_t StepTimer::get_fps() const
 {
     return _frames_per_second;
+}
+
+uint32_t StepTimer::get_frame_count() const
+{
+    return _frame_count;
+}
+
+uint64_t StepTimer::get_elapsed_ticks() const
+{
+    return _elapsed_ticks;
+}
+
+double StepTimer::get_elapsed_seconds() const
+{
+    return ticks_to_seconds(_elapsed_ticks);
+}
+
+uint64_t StepTimer::get_total_ticks() const
+{
+    return _total_ticks;
+}
+
+double StepTimer::get_total_seconds() const
+{
+    return ticks_to_seconds(_total_ticks);
+}
+
+double StepTimer::get_frame_seconds() const
+{
+    return ticks_to_seconds(_frame_ticks);
+}
+
+float StepTimer::get_interpolation_alpha() const
+{
+    if (!_is_fixed_time_step)
+    {
+        return 0.0f;
+    }
+
+    return static_cast<float>(static_cast<double>(_left_over_ticks) / static_cast<double>(_target_elapsed_ticks));
+}
+
+const FrameStats& StepTimer::get_frame_stats() const
+{
+    return _frame_stats;
+}
+
+FrameStats& StepTimer::get_frame_stats()
+{
+    return _frame_stats;
+}
+
+void StepTimer::set_fixed_time_step(bool is_fixed_time_step)
+{
+    _is_fixed_time_step = is_fixed_time_step;
+}
+
+bool StepTimer::is_fixed_time_step() const
+{
+    return _is_fixed_time_step;
+}
+
+void StepTimer::set_target_elapsed_ticks(uint64_t target_elapsed)
+{
+    // a fixed step of 0 would never consume the left over time
+    if (target_elapsed == 0)
+    {
+        throw std::invalid_argument("StepTimer: target elapsed time must be at least one tick");
+    }
+
+    _target_elapsed_ticks = target_elapsed;
+}
+
+void StepTimer::set_target_elapsed_seconds(double target_elapsed)
+{
+    if (!(target_elapsed > 0.0))
+    {
+        throw std::invalid_argument("StepTimer: target elapsed time must be positive");
+    }
+
+    set_target_elapsed_ticks(seconds_to_ticks(target_elapsed));
 }
\ No newline at end of file
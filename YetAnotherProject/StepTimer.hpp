@@ -1,32 +1,117 @@
 #pragma once
 
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN
-#endif
-#include <Windows.h>
+#include <cstdint>
+#include <functional>
+
+#include "FrameStats.hpp"
 
 class StepTimer
 {
 public:
+    // Source of the current time, in ticks of the given frequency (ticks per second).
+    // Can be replaced by a manually advanced counter for deterministic tests.
+    struct ClockSource
+    {
+        std::function<uint64_t()> now;
+        uint64_t frequency;
+    };
+
+    // std::chrono::steady_clock, i.e. QueryPerformanceCounter on windows and clock_gettime(CLOCK_MONOTONIC) on linux
+    static ClockSource steady_clock_source();
+
     StepTimer();
+    explicit StepTimer(ClockSource clock_source);
+
+    // Time is represented in ticks, 10,000,000 ticks per second.
+    static const uint64_t ticks_per_second = 10000000;
+
+    static constexpr double ticks_to_seconds(uint64_t ticks) { return static_cast<double>(ticks) / ticks_per_second; }
+    static constexpr uint64_t seconds_to_ticks(double seconds) { return static_cast<uint64_t>(seconds * ticks_per_second); }
 
     void reset_elapsed_time();
+
+    // Advances the clock and calls update once per fixed step that passed (possibly zero times),
+    // or exactly once with the measured time in variable step mode.
+    template <typename Update>
+    void tick(const Update& update)
+    {
+        const uint64_t time_delta = query_time_delta();
+        const uint32_t last_frame_count = _frame_count;
+
+        if (_is_fixed_time_step)
+        {
+            accumulate_fixed_time(time_delta);
+
+            while (_left_over_ticks >= _target_elapsed_ticks)
+            {
+                _elapsed_ticks = _target_elapsed_ticks;
+                _total_ticks += _target_elapsed_ticks;
+                _left_over_ticks -= _target_elapsed_ticks;
+                _frame_count++;
+
+                update();
+            }
+        }
+        else
+        {
+            _elapsed_ticks = time_delta;
+            _total_ticks += time_delta;
+            _left_over_ticks = 0;
+            _frame_count++;
+
+            update();
+        }
+
+        track_frame_rate(last_frame_count);
+    }
+
     void tick();
-    UINT32 get_fps() const;
+
+    uint32_t get_fps() const;
+    uint32_t get_frame_count() const;
+
+    // Duration of the last update step, i.e. the fixed step or the measured time in variable step mode.
+    uint64_t get_elapsed_ticks() const;
+    double get_elapsed_seconds() const;
+    uint64_t get_total_ticks() const;
+    double get_total_seconds() const;
+    // Measured (clamped) duration of the last tick, independent of the step mode. Use this for rendering.
+    double get_frame_seconds() const;
+    // Fraction of a fixed step that is left over after the last tick, in [0, 1).
+    // Render with lerp(previous_state, current_state, alpha) to hide the difference between update and render rate.
+    float get_interpolation_alpha() const;
+
+    // Unclamped durations of the recent ticks, use these to find stutter that the fps value averages away.
+    const FrameStats& get_frame_stats() const;
+    FrameStats& get_frame_stats();
+
+    void set_fixed_time_step(bool is_fixed_time_step);
+    bool is_fixed_time_step() const;
+    // throws std::invalid_argument for targets that are 0 ticks long
+    void set_target_elapsed_ticks(uint64_t target_elapsed);
+    void set_target_elapsed_seconds(double target_elapsed);
+
 private:
-    static const UINT64 ticks_per_second = 10000000;
-    LARGE_INTEGER _qpc_frequency;
-    LARGE_INTEGER _qpc_last_time;
-    UINT64 _qpc_max_delta;
+    ClockSource _clock;
+    uint64_t _clock_last_time;
+    uint64_t _clock_max_delta;
+
+    uint64_t _elapsed_ticks;
+    uint64_t _total_ticks;
+    uint64_t _left_over_ticks;
+    uint64_t _frame_ticks;
+
+    uint32_t _frame_count;
+    uint32_t _frames_per_second;
+    uint32_t _frames_this_second;
+    uint64_t _clock_second_counter;
 
-    UINT64 _elapsed_ticks;
-    UINT64 _total_ticks;
-    UINT64 _left_over_ticks;
+    bool _is_fixed_time_step;
+    uint64_t _target_elapsed_ticks;
 
-    UINT32 _frame_count;
-    UINT32 _frames_per_second;
-    UINT32 _frames_this_second;
-    UINT64 _qpc_second_counter;
+    FrameStats _frame_stats;
 
-    UINT64 _target_elapsed_ticks;
+    uint64_t query_time_delta();
+    void accumulate_fixed_time(uint64_t time_delta);
+    void track_frame_rate(uint32_t last_frame_count);
 };
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "TransformHierarchy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#include "JobSystem.hpp"
+
+TransformHierarchy::Node TransformHierarchy::add(Node parent, const mat4f& local)
+{
+    if (parent != no_parent)
+    {
+        check_node(parent);
+    }
+
+    const Node node = static_cast<Node>(_parents.size());
+    const uint32_t slot = static_cast<uint32_t>(_nodes.size());
+
+    _slots.push_back(slot);
+    _parents.push_back(parent);
+    _depths.push_back(parent == no_parent ? 0 : _depths[parent] + 1);
+
+    // appended for now, update sorts it into its level
+    _nodes.push_back(node);
+    _parent_slots.push_back(parent == no_parent ? no_parent : _slots[parent]);
+    _locals.push_back(local);
+    _worlds.push_back(local);
+    _dirty.push_back(1);
+
+    _order_dirty = true;
+    return node;
+}
+
+void TransformHierarchy::clear()
+{
+    _slots.clear();
+    _parents.clear();
+    _depths.clear();
+    _nodes.clear();
+    _parent_slots.clear();
+    _locals.clear();
+    _worlds.clear();
+    _dirty.clear();
+    _level_begin.clear();
+    _order_dirty = false;
+}
+
+void TransformHierarchy::reserve(std::size_t count)
+{
+    _slots.reserve(count);
+    _parents.reserve(count);
+    _depths.reserve(count);
+    _nodes.reserve(count);
+    _parent_slots.reserve(count);
+    _locals.reserve(count);
+    _worlds.reserve(count);
+    _dirty.reserve(count);
+}
+
+void TransformHierarchy::set_local(Node node, const mat4f& local)
+{
+    check_node(node);
+    const uint32_t slot = _slots[node];
+    _locals[slot] = local;
+    _dirty[slot] = 1;
+}
+
+const mat4f& TransformHierarchy::get_local(Node node) const
+{
+    check_node(node);
+    return _locals[_slots[node]];
+}
+
+const mat4f& TransformHierarchy::get_world(Node node) const
+{
+    check_node(node);
+    return _worlds[_slots[node]];
+}
+
+TransformHierarchy::Node TransformHierarchy::get_parent(Node node) const
+{
+    check_node(node);
+    return _parents[node];
+}
+
+uint32_t TransformHierarchy::get_depth(Node node) const
+{
+    check_node(node);
+    return _depths[node];
+}
+
+std::size_t TransformHierarchy::size() const
+{
+    return _nodes.size();
+}
+
+std::size_t TransformHierarchy::get_level_count() const
+{
+    return _level_begin.empty() ? 0 : _level_begin.size() - 1;
+}
+
+std::span<const mat4f> TransformHierarchy::get_world_matrices() const
+{
+    return _worlds;
+}
+
+uint32_t TransformHierarchy::get_slot(Node node) const
+{
+    check_node(node);
+    return _slots[node];
+}
+
+void TransformHierarchy::check_node(Node node) const
+{
+    if (node >= _parents.size())
+    {
+        throw std::invalid_argument("TransformHierarchy: unknown node");
+    }
+}
+
+// Counting sort by depth, stable so siblings keep the order they were added in.
+void TransformHierarchy::sort_breadth_first()
+{
+    const std::size_t count = _nodes.size();
+    const uint32_t max_depth = count == 0 ? 0 : *std::max_element(_depths.begin(), _depths.end());
+
+    _level_begin.assign(static_cast<std::size_t>(max_depth) + 2, 0);
+    for (const uint32_t depth : _depths)
+    {
+        _level_begin[depth + 1]++;
+    }
+    for (std::size_t level = 1; level < _level_begin.size(); ++level)
+    {
+        _level_begin[level] += _level_begin[level - 1];
+    }
+
+    std::vector<uint32_t> next_slot(_level_begin.begin(), _level_begin.end() - 1);
+    std::vector<uint32_t> new_slots(count);
+    for (Node node = 0; node < count; ++node)
+    {
+        new_slots[node] = next_slot[_depths[node]]++;
+    }
+
+    std::vector<Node> nodes(count);
+    std::vector<uint32_t> parent_slots(count);
+    std::vector<mat4f> locals(count);
+    std::vector<mat4f> worlds(count);
+    std::vector<uint8_t> dirty(count);
+    for (Node node = 0; node < count; ++node)
+    {
+        const uint32_t old_slot = _slots[node];
+        const uint32_t slot = new_slots[node];
+        nodes[slot] = node;
+        parent_slots[slot] = _parents[node] == no_parent ? no_parent : new_slots[_parents[node]];
+        locals[slot] = _locals[old_slot];
+        worlds[slot] = _worlds[old_slot];
+        dirty[slot] = _dirty[old_slot];
+    }
+
+    _slots = std::move(new_slots);
+    _nodes = std::move(nodes);
+    _parent_slots = std::move(parent_slots);
+    _locals = std::move(locals);
+    _worlds = std::move(worlds);
+    _dirty = std::move(dirty);
+    _order_dirty = false;
+}
+
+// The parents' dirty flags are final once their level is done, a node is dirty if it or its parent is.
+std::size_t TransformHierarchy::update_level(std::size_t first, std::size_t last)
+{
+    std::size_t updated = 0;
+    for (std::size_t slot = first; slot < last; ++slot)
+    {
+        const uint32_t parent = _parent_slots[slot];
+        if (parent != no_parent)
+        {
+            _dirty[slot] |= _dirty[parent];
+        }
+
+        if (_dirty[slot])
+        {
+            _worlds[slot] = parent == no_parent ? _locals[slot] : mat::multiply(_worlds[parent], _locals[slot]);
+            updated++;
+        }
+    }
+    return updated;
+}
+
+std::size_t TransformHierarchy::update(JobSystem* job_system, std::size_t grain_size)
+{
+    if (_order_dirty)
+    {
+        sort_breadth_first();
+    }
+
+    std::size_t updated = 0;
+    for (std::size_t level = 0; level + 1 < _level_begin.size(); ++level)
+    {
+        const std::size_t first = _level_begin[level];
+        const std::size_t last = _level_begin[level + 1];
+
+        if (job_system && last - first > grain_size)
+        {
+            std::atomic<std::size_t> level_updated = 0;
+            job_system->parallel_for(first, last, grain_size, [this, &level_updated](std::size_t begin, std::size_t end)
+            {
+                level_updated.fetch_add(update_level(begin, end), std::memory_order_relaxed);
+            });
+            updated += level_updated.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            updated += update_level(first, last);
+        }
+    }
+
+    // children read their parent's flag, so the flags are only reset once every level is done
+    std::fill(_dirty.begin(), _dirty.end(), static_cast<uint8_t>(0));
+    return updated;
+}
\ No newline at end of file
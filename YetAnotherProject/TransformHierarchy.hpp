@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "mat4.hpp"
+
+class JobSystem;
+
+// Parent / child transforms in flat arrays sorted breadth first, so every depth level is a contiguous range
+// and parents always come before their children. update walks the levels in order and recomputes
+// world = parent world * local only for nodes whose local transform, or any ancestor's, changed since the
+// last update. The nodes of a level don't depend on each other and are split across the job system.
+class TransformHierarchy
+{
+public:
+    using Node = uint32_t;
+    static constexpr Node no_parent = UINT32_MAX;
+    // nodes per job, a world matrix is only a few nanoseconds of work
+    static constexpr std::size_t default_grain_size = 2048;
+
+    // Node handles are stable, parent has to be an existing node or no_parent for a root.
+    // Throws std::invalid_argument for an unknown parent.
+    Node add(Node parent, const mat4f& local = mat::identity());
+    void clear();
+    void reserve(std::size_t count);
+
+    // marks the node and its subtree for the next update
+    void set_local(Node node, const mat4f& local);
+    const mat4f& get_local(Node node) const;
+    // as of the last update
+    const mat4f& get_world(Node node) const;
+    Node get_parent(Node node) const;
+    uint32_t get_depth(Node node) const;
+
+    std::size_t size() const;
+    std::size_t get_level_count() const;
+
+    // Recomputes the world matrices of all dirty subtrees, level by level. Parallel with a job system.
+    // Returns the number of world matrices that were recomputed.
+    std::size_t update(JobSystem* job_system = nullptr, std::size_t grain_size = default_grain_size);
+
+    // world matrices in breadth first order, get_slot maps a node into it (valid until the next add)
+    std::span<const mat4f> get_world_matrices() const;
+    uint32_t get_slot(Node node) const;
+
+private:
+    // indexed by node
+    std::vector<uint32_t> _slots;
+    std::vector<Node> _parents;
+    std::vector<uint32_t> _depths;
+
+    // indexed by slot, breadth first
+    std::vector<Node> _nodes;
+    std::vector<uint32_t> _parent_slots;
+    std::vector<mat4f> _locals;
+    std::vector<mat4f> _worlds;
+    // uint8_t instead of bool, neighbouring flags are written by different threads
+    std::vector<uint8_t> _dirty;
+
+    // first slot of every depth level, plus the end
+    std::vector<uint32_t> _level_begin;
+    // nodes were added since the last sort
+    bool _order_dirty = false;
+
+    void check_node(Node node) const;
+    void sort_breadth_first();
+    std::size_t update_level(std::size_t first, std::size_t last);
+};
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "UploadAllocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    bool is_power_of_two(uint64_t value)
+    {
+        return value != 0 && (value & (value - 1)) == 0;
+    }
+
+    uint64_t align_up(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+UploadAllocator::UploadAllocator(uint8_t* cpu_base, uint64_t gpu_base, uint64_t bytes_per_frame, uint32_t frame_count)
+    : _cpu_base(cpu_base),
+    _gpu_base(gpu_base),
+    _bytes_per_frame(bytes_per_frame),
+    _frame_count(frame_count),
+    _frame_index(0),
+    _head(0),
+    _allocation_count(0),
+    _peak_used_bytes(0)
+{
+    if (cpu_base == nullptr)
+    {
+        throw std::invalid_argument("UploadAllocator: no memory to allocate from");
+    }
+    if (frame_count == 0)
+    {
+        throw std::invalid_argument("UploadAllocator: at least one frame is required");
+    }
+    if (bytes_per_frame == 0 || bytes_per_frame % constant_buffer_alignment != 0)
+    {
+        throw std::invalid_argument("UploadAllocator: bytes per frame must be a non zero multiple of 256");
+    }
+}
+
+void UploadAllocator::begin_frame(uint32_t frame_index)
+{
+    if (frame_index >= _frame_count)
+    {
+        throw std::out_of_range("UploadAllocator: frame index out of range");
+    }
+
+    _frame_index = frame_index;
+    _head = 0;
+    _allocation_count = 0;
+}
+
+UploadAllocator::Allocation UploadAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+    // checked before aligning anything, huge sizes or alignments would wrap around in align_up
+    if (!is_power_of_two(alignment) || alignment > _bytes_per_frame)
+    {
+        throw std::invalid_argument("UploadAllocator: alignment must be a power of two no larger than the bytes per frame");
+    }
+    if (size > _bytes_per_frame)
+    {
+        throw std::length_error("UploadAllocator: allocation larger than the bytes per frame");
+    }
+
+    // aligned relative to the gpu address, the region start itself is only 256 byte aligned
+    const uint64_t region_offset = static_cast<uint64_t>(_frame_index) * _bytes_per_frame;
+    const uint64_t region_gpu_base = _gpu_base + region_offset;
+    const uint64_t begin = align_up(region_gpu_base + _head, alignment) - region_gpu_base;
+    const uint64_t aligned_size = align_up(std::max<uint64_t>(size, 1), alignment);
+
+    if (begin > _bytes_per_frame || aligned_size > _bytes_per_frame - begin)
+    {
+        throw std::length_error("UploadAllocator: upload memory of the frame exhausted");
+    }
+
+    _head = begin + aligned_size;
+    _allocation_count++;
+    _peak_used_bytes = std::max(_peak_used_bytes, _head);
+
+    const uint64_t offset = region_offset + begin;
+    return { _cpu_base + offset, _gpu_base + offset, offset, aligned_size };
+}
+
+uint32_t UploadAllocator::get_frame_count() const
+{
+    return _frame_count;
+}
+
+uint32_t UploadAllocator::get_frame_index() const
+{
+    return _frame_index;
+}
+
+uint64_t UploadAllocator::get_bytes_per_frame() const
+{
+    return _bytes_per_frame;
+}
+
+uint64_t UploadAllocator::get_used_bytes() const
+{
+    return _head;
+}
+
+uint64_t UploadAllocator::get_allocation_count() const
+{
+    return _allocation_count;
+}
+
+uint64_t UploadAllocator::get_peak_used_bytes() const
+{
+    return _peak_used_bytes;
+}
\ No newline at end of file
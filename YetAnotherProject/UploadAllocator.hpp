@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Linear suballocator for data the gpu reads once per frame (constants, dynamic geometry). One persistently
+// mapped block is split into a region per frame in flight. Allocations bump an offset inside the region of
+// the current frame and the whole region is recycled at once when its frame slot comes around again, which
+// FrameFence only allows after the gpu finished the frame that used it. Nothing here is api specific, the
+// gpu addresses are the block's base address plus the offset, so it runs over plain memory as well.
+// Not thread safe, allocate from one thread (or give every thread its own allocator).
+class UploadAllocator
+{
+public:
+    // d3d12 requires constant buffer views and root cbvs to start at multiples of 256 bytes
+    static const uint64_t constant_buffer_alignment = 256;
+
+    struct Allocation
+    {
+        uint8_t* cpu_address;
+        uint64_t gpu_address;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // cpu_base points to frame_count * bytes_per_frame bytes, gpu_base is the gpu address of the same byte.
+    // bytes_per_frame has to be a multiple of constant_buffer_alignment, otherwise std::invalid_argument is thrown.
+    UploadAllocator(uint8_t* cpu_base, uint64_t gpu_base, uint64_t bytes_per_frame, uint32_t frame_count);
+
+    // Recycles the region of frame_index, everything allocated in it during its last frame becomes invalid.
+    void begin_frame(uint32_t frame_index);
+
+    // size is rounded up to the alignment, which has to be a power of two no larger than the bytes per frame
+    // (std::invalid_argument otherwise). Throws std::length_error when the region of the current frame is
+    // exhausted, raise the bytes per frame in that case.
+    Allocation allocate(uint64_t size, uint64_t alignment = constant_buffer_alignment);
+
+    // copies data into a new allocation
+    template <typename T>
+    Allocation push(const T& data, uint64_t alignment = constant_buffer_alignment)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Upload data must be trivially copyable");
+
+        const Allocation allocation = allocate(sizeof(T), alignment);
+        std::memcpy(allocation.cpu_address, &data, sizeof(T));
+        return allocation;
+    }
+
+    uint32_t get_frame_count() const;
+    uint32_t get_frame_index() const;
+    uint64_t get_bytes_per_frame() const;
+    // bytes and allocations of the current frame so far
+    uint64_t get_used_bytes() const;
+    uint64_t get_allocation_count() const;
+    // most bytes any frame used since construction, to size the regions
+    uint64_t get_peak_used_bytes() const;
+
+private:
+    uint8_t* _cpu_base;
+    uint64_t _gpu_base;
+    uint64_t _bytes_per_frame;
+    uint32_t _frame_count;
+    uint32_t _frame_index;
+    uint64_t _head;
+    uint64_t _allocation_count;
+    uint64_t _peak_used_bytes;
+};
\ No newline at end of file
@@ -3,20 +3,17 @@
 void Application::initialize()
 {
 	_gc.initialize();
+	_scene.initialize(_gc);
 }
 
 void Application::runApplication() {
 	bool bRun = true;
 	MSG msg;
 
-	ULONGLONG frameticks = 0;
-	float frametime = 0.0f;
-
 	// rc.UpdateProjectionMatrix(ProjeMatrix(180, 800.0f / 600.0f, 1.0f, 100.0f));
 
 	while (bRun)
 	{
-		frameticks = GetTickCount64();
 		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 		{
 			TranslateMessage(&msg);
@@ -43,13 +40,11 @@ void Application::runApplication() {
 		gc.swapchain->Present(0, 0);*/
 
 		// samples actually update and render on WndProc WM_PAINT
-		_step_timer.tick();
-		_gc.triangle_render(frametime);
-
-
-
-		frameticks = (GetTickCount64() - frameticks);
-		frametime = static_cast<float>(frameticks / 1000.0f);
+		// the simulation runs in fixed steps from within tick, render draws the state of the last step
+		_step_timer.tick([&] { _scene.update(_step_timer.get_elapsed_seconds()); });
+		_scene.render(_gc);
+		// uncapped unless a target frame rate is set, vsync throttles in that case
+		_frame_pacer.wait_for_next_frame();
 	}
 
 	_gc.exit();
@@ -58,7 +53,7 @@ void Application::runApplication() {
 Win32::WindowClassType<Application, &Application::WndProc> Application::wct(L"windowclassname", 0, 0, 0, 0);
 
 Application::Application(const std::wstring& title, int width, int height, DWORD dwStyle, DWORD dwExStyle)
-	: windowHandle(wct.createWindow(*this, dwExStyle, title.c_str(), dwStyle, width, height)), _gc(windowHandle, width, height)
+	: windowHandle(wct.createWindow(*this, dwExStyle, title.c_str(), dwStyle, width, height)), _gc(windowHandle, width, height, &_job_system)
 {
 	ShowWindow(windowHandle, 1);
 	UpdateWindow(windowHandle);
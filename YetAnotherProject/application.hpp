@@ -3,7 +3,10 @@
 #include <string>
 #include "WindowClassType.hpp"
 #include "GraphicContext.hpp"
+#include "Scene.hpp"
 
+#include "FramePacer.hpp"
+#include "JobSystem.hpp"
 #include "StepTimer.hpp"
 
 struct Application
@@ -17,5 +20,8 @@ private:
 	static Win32::WindowClassType<Application, &WndProc> wct;
 
 	StepTimer _step_timer;
+	FramePacer _frame_pacer;
+	JobSystem _job_system;
 	GraphicContext _gc;
+	Scene _scene;
 };
\ No newline at end of file
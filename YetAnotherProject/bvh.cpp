@@ -0,0 +1,588 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "simd.hpp"
+
+using namespace simd;
+
+namespace spatial {
+	namespace {
+		constexpr float infinity = std::numeric_limits<float>::infinity();
+
+		aabb empty_box()
+		{
+			return { vec3f(infinity, infinity, infinity), vec3f(-infinity, -infinity, -infinity) };
+		}
+
+		void grow(aabb& box, const aabb& other)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				box.min[i] = std::min(box.min[i], other.min[i]);
+				box.max[i] = std::max(box.max[i], other.max[i]);
+			}
+		}
+
+		void grow(aabb& box, const vec3f& point)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				box.min[i] = std::min(box.min[i], point[i]);
+				box.max[i] = std::max(box.max[i], point[i]);
+			}
+		}
+
+		// half the surface area, the factor doesn't matter for comparing costs
+		float half_area(const aabb& box)
+		{
+			const float x = box.max.x - box.min.x;
+			const float y = box.max.y - box.min.y;
+			const float z = box.max.z - box.min.z;
+			return x * y + y * z + z * x;
+		}
+
+		aabb node_box(const bvh::node& n)
+		{
+			return { vec3f(n.min[0], n.min[1], n.min[2]), vec3f(n.max[0], n.max[1], n.max[2]) };
+		}
+
+		void set_node_box(bvh::node& n, const aabb& box)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				n.min[i] = box.min[i];
+				n.max[i] = box.max[i];
+			}
+		}
+
+		bool overlaps(const aabb& a, const aabb& b)
+		{
+			return a.min.x <= b.max.x && b.min.x <= a.max.x
+				&& a.min.y <= b.max.y && b.min.y <= a.max.y
+				&& a.min.z <= b.max.z && b.min.z <= a.max.z;
+		}
+
+		// Zero direction components would produce 0 * inf = nan in the slab test when the origin lies on
+		// a slab plane, a tiny component of the same sign gives the same result without the nan.
+		float safe_inverse(float d)
+		{
+			constexpr float epsilon = 1e-20f;
+			return 1.0f / (std::fabs(d) < epsilon ? std::copysign(epsilon, d) : d);
+		}
+
+		struct prepared_ray
+		{
+			float origin[3];
+			float inv_direction[3];
+		};
+
+		prepared_ray prepare(const ray& r)
+		{
+			return { { r.origin.x, r.origin.y, r.origin.z },
+				{ safe_inverse(r.direction.x), safe_inverse(r.direction.y), safe_inverse(r.direction.z) } };
+		}
+
+		// entry distance into the box clamped to 0, infinity if the ray misses it before t_max
+		float slab(const prepared_ray& r, const float* box_min, const float* box_max, float t_max)
+		{
+			float t_near = 0.0f;
+			float t_far = t_max;
+			for (int i = 0; i < 3; ++i)
+			{
+				const float t0 = (box_min[i] - r.origin[i]) * r.inv_direction[i];
+				const float t1 = (box_max[i] - r.origin[i]) * r.inv_direction[i];
+				t_near = std::max(t_near, std::min(t0, t1));
+				t_far = std::min(t_far, std::max(t0, t1));
+			}
+			return t_near <= t_far ? t_near : infinity;
+		}
+
+		int bit_count(int bits)
+		{
+			return (bits & 1) + ((bits >> 1) & 1) + ((bits >> 2) & 1) + ((bits >> 3) & 1);
+		}
+
+		// four rays in structure of arrays layout
+		struct ray_packet
+		{
+			float4 origin_x, origin_y, origin_z;
+			float4 inv_x, inv_y, inv_z;
+		};
+
+		// slab test of four rays against one box, returns the entry distances (clamped to 0) and the hit mask
+		float4 slab(const ray_packet& p, const float* box_min, const float* box_max, float4 closest, float4& t_near)
+		{
+			const float4 tx0 = (set1(box_min[0]) - p.origin_x) * p.inv_x;
+			const float4 tx1 = (set1(box_max[0]) - p.origin_x) * p.inv_x;
+			const float4 ty0 = (set1(box_min[1]) - p.origin_y) * p.inv_y;
+			const float4 ty1 = (set1(box_max[1]) - p.origin_y) * p.inv_y;
+			const float4 tz0 = (set1(box_min[2]) - p.origin_z) * p.inv_z;
+			const float4 tz1 = (set1(box_max[2]) - p.origin_z) * p.inv_z;
+
+			t_near = max(max(min(tx0, tx1), min(ty0, ty1)), max(min(tz0, tz1), set1(0.0f)));
+			const float4 t_far = min(min(max(tx0, tx1), max(ty0, ty1)), min(max(tz0, tz1), closest));
+			return t_near <= t_far;
+		}
+	}
+
+	void bvh::build(std::span<const aabb> boxes)
+	{
+		clear();
+		if (boxes.empty())
+			return;
+
+		if (boxes.size() >= UINT32_MAX)
+			throw std::invalid_argument("spatial::bvh: too many primitives");
+
+		std::vector<build_primitive> primitives(boxes.size());
+		for (std::size_t i = 0; i < boxes.size(); ++i)
+		{
+			const aabb& box = boxes[i];
+			primitives[i] = { box, (box.min + box.max) * 0.5f, static_cast<uint32_t>(i) };
+		}
+
+		// a binary tree with at least one primitive per leaf has less than two nodes per primitive
+		_nodes.reserve(boxes.size() * 2);
+		build_node(primitives, 0, static_cast<uint32_t>(primitives.size()), 1);
+
+		_primitives.resize(primitives.size());
+		_boxes.resize(primitives.size());
+		for (std::size_t i = 0; i < primitives.size(); ++i)
+		{
+			_primitives[i] = primitives[i].index;
+			_boxes[i] = primitives[i].box;
+		}
+	}
+
+	uint32_t bvh::build_node(std::vector<build_primitive>& primitives, uint32_t first, uint32_t count, uint32_t depth)
+	{
+		const uint32_t index = static_cast<uint32_t>(_nodes.size());
+		_nodes.emplace_back();
+		_depth = std::max(_depth, depth);
+
+		aabb bounds = empty_box();
+		aabb centroid_bounds = empty_box();
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			grow(bounds, primitives[i].box);
+			grow(centroid_bounds, primitives[i].centroid);
+		}
+		set_node_box(_nodes[index], bounds);
+
+		if (count <= max_leaf_size || depth >= max_depth)
+		{
+			_nodes[index].offset = first;
+			_nodes[index].count = count;
+			return index;
+		}
+
+		// binned sah: the centroids are sorted into bins along every axis and every border between two bins
+		// is rated by the surface areas and primitive counts of both sides
+		struct bin
+		{
+			aabb box;
+			uint32_t count;
+		};
+
+		float best_cost = infinity;
+		int best_axis = -1;
+		uint32_t best_split = 0;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+			if (extent <= 0.0f)
+				continue;
+
+			bin bins[bin_count];
+			for (auto& b : bins)
+				b = { empty_box(), 0 };
+
+			const float scale = bin_count / extent;
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const uint32_t b = std::min(bin_count - 1, static_cast<uint32_t>((primitives[i].centroid[axis] - centroid_bounds.min[axis]) * scale));
+				grow(bins[b].box, primitives[i].box);
+				bins[b].count++;
+			}
+
+			// sweep from the left and the right, split s puts bins [0, s) to the left
+			float left_cost[bin_count];
+			aabb left_box = empty_box();
+			uint32_t left_count = 0;
+			for (uint32_t s = 1; s < bin_count; ++s)
+			{
+				grow(left_box, bins[s - 1].box);
+				left_count += bins[s - 1].count;
+				left_cost[s] = left_count ? half_area(left_box) * left_count : 0.0f;
+			}
+
+			aabb right_box = empty_box();
+			uint32_t right_count = 0;
+			for (uint32_t s = bin_count - 1; s > 0; --s)
+			{
+				grow(right_box, bins[s].box);
+				right_count += bins[s].count;
+				const float cost = left_cost[s] + (right_count ? half_area(right_box) * right_count : 0.0f);
+				if (cost < best_cost && right_count > 0 && right_count < count)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_split = s;
+				}
+			}
+		}
+
+		uint32_t middle;
+		if (best_axis >= 0)
+		{
+			const float min = centroid_bounds.min[best_axis];
+			const float scale = bin_count / (centroid_bounds.max[best_axis] - min);
+			const auto it = std::partition(primitives.begin() + first, primitives.begin() + first + count, [&](const build_primitive& p)
+			{
+				return std::min(bin_count - 1, static_cast<uint32_t>((p.centroid[best_axis] - min) * scale)) < best_split;
+			});
+			middle = static_cast<uint32_t>(it - primitives.begin());
+		}
+		else
+		{
+			// all centroids in one point, any split is as good as another
+			middle = first + count / 2;
+		}
+
+		if (middle == first || middle == first + count)
+			middle = first + count / 2;
+
+		build_node(primitives, first, middle - first, depth + 1);
+		const uint32_t right = build_node(primitives, middle, first + count - middle, depth + 1);
+		_nodes[index].offset = right;
+		_nodes[index].count = 0;
+		return index;
+	}
+
+	void bvh::refit(std::span<const aabb> boxes)
+	{
+		if (boxes.size() != _primitives.size())
+			throw std::invalid_argument("spatial::bvh: refit with a different number of primitives");
+
+		for (std::size_t i = 0; i < _primitives.size(); ++i)
+			_boxes[i] = boxes[_primitives[i]];
+
+		// children are stored after their parents, so a backwards pass sees them first
+		for (std::size_t i = _nodes.size(); i-- > 0;)
+		{
+			node& n = _nodes[i];
+			aabb bounds = empty_box();
+			if (n.count > 0)
+			{
+				for (uint32_t p = n.offset; p < n.offset + n.count; ++p)
+					grow(bounds, _boxes[p]);
+			}
+			else
+			{
+				grow(bounds, node_box(_nodes[i + 1]));
+				grow(bounds, node_box(_nodes[n.offset]));
+			}
+			set_node_box(n, bounds);
+		}
+	}
+
+	void bvh::clear()
+	{
+		_nodes.clear();
+		_primitives.clear();
+		_boxes.clear();
+		_depth = 0;
+	}
+
+	ray_hit bvh::raycast(const ray& r) const
+	{
+		ray_hit hit = { ray_hit::no_hit, r.t_max };
+		if (_nodes.empty())
+			return hit;
+
+		const prepared_ray p = prepare(r);
+
+		struct entry
+		{
+			uint32_t node;
+			float t;
+		};
+		entry stack[max_depth + 1];
+		uint32_t stack_size = 0;
+
+		const float root_t = slab(p, _nodes[0].min, _nodes[0].max, hit.t);
+		if (root_t != infinity)
+			stack[stack_size++] = { 0, root_t };
+
+		while (stack_size > 0)
+		{
+			const entry e = stack[--stack_size];
+			// a closer hit was found since the node was pushed
+			if (e.t > hit.t)
+				continue;
+
+			const node& n = _nodes[e.node];
+			if (n.count > 0)
+			{
+				for (uint32_t i = n.offset; i < n.offset + n.count; ++i)
+				{
+					// hits are inclusive of t_max (the first hit may be at exactly hit.t), infinity is a miss
+					const float t = slab(p, &_boxes[i].min.x, &_boxes[i].max.x, hit.t);
+					if (t != infinity && (t < hit.t || (t == hit.t && hit.primitive == ray_hit::no_hit)))
+						hit = { _primitives[i], t };
+				}
+				continue;
+			}
+
+			// visit the nearer child first, it is pushed last
+			const uint32_t left = e.node + 1;
+			const uint32_t right = n.offset;
+			float t_left = slab(p, _nodes[left].min, _nodes[left].max, hit.t);
+			float t_right = slab(p, _nodes[right].min, _nodes[right].max, hit.t);
+			entry near_entry = { left, t_left };
+			entry far_entry = { right, t_right };
+			if (t_right < t_left)
+				std::swap(near_entry, far_entry);
+
+			if (far_entry.t != infinity)
+				stack[stack_size++] = far_entry;
+			if (near_entry.t != infinity)
+				stack[stack_size++] = near_entry;
+		}
+
+		if (hit.primitive == ray_hit::no_hit)
+			hit.t = r.t_max;
+		return hit;
+	}
+
+	void bvh::raycast(std::span<const ray> rays, std::span<ray_hit> hits) const
+	{
+		if (hits.size() < rays.size())
+			throw std::invalid_argument("spatial::bvh: not enough room for the ray hits");
+
+		for (std::size_t base = 0; base < rays.size(); base += 4)
+		{
+			const std::size_t lanes = std::min<std::size_t>(4, rays.size() - base);
+
+			// unused lanes repeat the first ray with a negative t_max, so they never hit anything
+			alignas(16) float values[7][4];
+			for (std::size_t lane = 0; lane < 4; ++lane)
+			{
+				const ray& r = rays[base + (lane < lanes ? lane : 0)];
+				const prepared_ray p = prepare(r);
+				values[0][lane] = p.origin[0];
+				values[1][lane] = p.origin[1];
+				values[2][lane] = p.origin[2];
+				values[3][lane] = p.inv_direction[0];
+				values[4][lane] = p.inv_direction[1];
+				values[5][lane] = p.inv_direction[2];
+				values[6][lane] = lane < lanes ? r.t_max : -1.0f;
+			}
+
+			const ray_packet packet = { load(values[0]), load(values[1]), load(values[2]), load(values[3]), load(values[4]), load(values[5]) };
+			float4 closest = load(values[6]);
+			uint32_t primitive[4] = { ray_hit::no_hit, ray_hit::no_hit, ray_hit::no_hit, ray_hit::no_hit };
+			// lanes without a hit yet, they accept one at exactly t_max like the single ray path
+			float4 searching = set1(0.0f) <= set1(0.0f);
+
+			// children are tested by their parent to visit the one most lanes reach first, the entry distances
+			// (infinity for lanes that miss) are kept to skip nodes behind hits found in the meantime
+			struct entry
+			{
+				uint32_t node;
+				float4 t_near;
+			};
+			entry stack[max_depth + 1];
+			uint32_t stack_size = 0;
+
+			if (!_nodes.empty())
+			{
+				float4 t_root;
+				const float4 root_hit = slab(packet, _nodes[0].min, _nodes[0].max, closest, t_root);
+				if (mask_bits(root_hit) != 0)
+					stack[stack_size++] = { 0, select(root_hit, t_root, set1(infinity)) };
+			}
+
+			while (stack_size > 0)
+			{
+				const entry e = stack[--stack_size];
+				if (mask_bits(e.t_near <= closest) == 0)
+					continue;
+
+				const node& n = _nodes[e.node];
+				if (n.count == 0)
+				{
+					const uint32_t left = e.node + 1;
+					const uint32_t right = n.offset;
+					float4 t_left, t_right;
+					const float4 left_hit = slab(packet, _nodes[left].min, _nodes[left].max, closest, t_left);
+					const float4 right_hit = slab(packet, _nodes[right].min, _nodes[right].max, closest, t_right);
+					entry near_entry = { left, select(left_hit, t_left, set1(infinity)) };
+					entry far_entry = { right, select(right_hit, t_right, set1(infinity)) };
+
+					const int right_first = mask_bits(far_entry.t_near < near_entry.t_near);
+					const int left_first = mask_bits(near_entry.t_near < far_entry.t_near);
+					if (bit_count(right_first) > bit_count(left_first))
+						std::swap(near_entry, far_entry);
+
+					if (mask_bits(far_entry.t_near < set1(infinity)) != 0)
+						stack[stack_size++] = far_entry;
+					if (mask_bits(near_entry.t_near < set1(infinity)) != 0)
+						stack[stack_size++] = near_entry;
+					continue;
+				}
+
+				for (uint32_t i = n.offset; i < n.offset + n.count; ++i)
+				{
+					float4 t;
+					const float4 box_hit = slab(packet, &_boxes[i].min.x, &_boxes[i].max.x, closest, t);
+					const float4 hit = box_hit & ((t < closest) | searching);
+					const int bits = mask_bits(hit);
+					if (bits == 0)
+						continue;
+
+					closest = select(hit, t, closest);
+					searching = select(hit, set1(0.0f), searching);
+					for (int lane = 0; lane < 4; ++lane)
+					{
+						if (bits & (1 << lane))
+							primitive[lane] = _primitives[i];
+					}
+				}
+			}
+
+			alignas(16) float t[4];
+			store(t, closest);
+			for (std::size_t lane = 0; lane < lanes; ++lane)
+				hits[base + lane] = { primitive[lane], t[lane] };
+		}
+	}
+
+	void bvh::query_frustum(const cull::frustum& f, std::vector<uint32_t>& primitives) const
+	{
+		if (_nodes.empty())
+			return;
+
+		// six planes in two groups of four, the padding planes contain everything
+		alignas(16) float plane_values[4][8];
+		for (int i = 0; i < 8; ++i)
+		{
+			const vec4f plane = i < cull::frustum::plane_count ? f.planes[i] : vec4f(0.0f, 0.0f, 0.0f, 1.0f);
+			for (int c = 0; c < 4; ++c)
+				plane_values[c][i] = plane[c];
+		}
+
+		float4 nx[2], ny[2], nz[2], d[2];
+		for (int g = 0; g < 2; ++g)
+		{
+			nx[g] = load(&plane_values[0][g * 4]);
+			ny[g] = load(&plane_values[1][g * 4]);
+			nz[g] = load(&plane_values[2][g * 4]);
+			d[g] = load(&plane_values[3][g * 4]);
+		}
+
+		// inside nodes are known to be in the frustum with all their children, those are not tested again
+		struct entry
+		{
+			uint32_t node;
+			bool inside;
+		};
+		entry stack[max_depth + 1];
+		uint32_t stack_size = 0;
+		stack[stack_size++] = { 0, false };
+
+		while (stack_size > 0)
+		{
+			const entry e = stack[--stack_size];
+			const node& n = _nodes[e.node];
+			bool inside = e.inside;
+
+			if (!inside)
+			{
+				const float4 cx = set1((n.min[0] + n.max[0]) * 0.5f);
+				const float4 cy = set1((n.min[1] + n.max[1]) * 0.5f);
+				const float4 cz = set1((n.min[2] + n.max[2]) * 0.5f);
+				const float4 ex = set1((n.max[0] - n.min[0]) * 0.5f);
+				const float4 ey = set1((n.max[1] - n.min[1]) * 0.5f);
+				const float4 ez = set1((n.max[2] - n.min[2]) * 0.5f);
+
+				bool outside = false;
+				bool contained = true;
+				for (int g = 0; g < 2; ++g)
+				{
+					const float4 distance = nx[g] * cx + ny[g] * cy + nz[g] * cz + d[g];
+					const float4 radius = abs(nx[g]) * ex + abs(ny[g]) * ey + abs(nz[g]) * ez;
+					outside = outside || mask_bits(distance < -radius) != 0;
+					contained = contained && mask_bits(distance >= radius) == 0xF;
+				}
+
+				if (outside)
+					continue;
+				inside = contained;
+			}
+
+			if (n.count > 0)
+			{
+				for (uint32_t i = n.offset; i < n.offset + n.count; ++i)
+				{
+					if (inside || cull::intersects_aabb(f, (_boxes[i].min + _boxes[i].max) * 0.5f, (_boxes[i].max - _boxes[i].min) * 0.5f))
+						primitives.push_back(_primitives[i]);
+				}
+				continue;
+			}
+
+			stack[stack_size++] = { n.offset, inside };
+			stack[stack_size++] = { e.node + 1, inside };
+		}
+	}
+
+	void bvh::query_aabb(const aabb& box, std::vector<uint32_t>& primitives) const
+	{
+		if (_nodes.empty())
+			return;
+
+		uint32_t stack[max_depth + 1];
+		uint32_t stack_size = 0;
+		stack[stack_size++] = 0;
+
+		while (stack_size > 0)
+		{
+			const uint32_t index = stack[--stack_size];
+			const node& n = _nodes[index];
+			if (!overlaps(node_box(n), box))
+				continue;
+
+			if (n.count > 0)
+			{
+				for (uint32_t i = n.offset; i < n.offset + n.count; ++i)
+				{
+					if (overlaps(_boxes[i], box))
+						primitives.push_back(_primitives[i]);
+				}
+				continue;
+			}
+
+			stack[stack_size++] = n.offset;
+			stack[stack_size++] = index + 1;
+		}
+	}
+
+	std::span<const bvh::node> bvh::get_nodes() const
+	{
+		return _nodes;
+	}
+
+	std::size_t bvh::get_primitive_count() const
+	{
+		return _primitives.size();
+	}
+
+	uint32_t bvh::get_depth() const
+	{
+		return _depth;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef BVH_INCLUDED
+#define BVH_INCLUDED
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "vec.hpp"
+#include "frustum.hpp"
+
+namespace spatial {
+	struct aabb
+	{
+		vec3f min;
+		vec3f max;
+	};
+
+	// direction doesn't have to be normalized, distances are measured in multiples of it
+	struct ray
+	{
+		vec3f origin;
+		vec3f direction;
+		float t_max;
+	};
+
+	struct ray_hit
+	{
+		static constexpr uint32_t no_hit = UINT32_MAX;
+
+		uint32_t primitive;
+		// entry distance into the primitive's box, 0 if the origin is inside
+		float t;
+	};
+
+	// Bounding volume hierarchy over boxes (one per primitive, e.g. the world bounds of entities).
+	// Built top down with a binned surface area heuristic into a flat array in depth first order:
+	// the left child directly follows its parent, so the nodes most traversals touch share cache lines.
+	// Moving primitives are handled by refit, which keeps the topology and only recomputes the bounds,
+	// rebuild once the tree quality degrades (bounds growing much larger than after the build).
+	// Queries don't modify the tree and may run on several threads.
+	class bvh
+	{
+	public:
+		static constexpr uint32_t max_leaf_size = 4;
+		static constexpr uint32_t bin_count = 16;
+		// deeper nodes become leaves regardless of their size, bounds the traversal stacks
+		static constexpr uint32_t max_depth = 64;
+
+		struct node
+		{
+			float min[3];
+			// interior: index of the right child (the left one is the next node), leaf: first primitive slot
+			uint32_t offset;
+			float max[3];
+			// primitives of a leaf, 0 for interior nodes
+			uint32_t count;
+		};
+
+		void build(std::span<const aabb> boxes);
+		// boxes must be the same primitives in the same order as for build, throws std::invalid_argument otherwise
+		void refit(std::span<const aabb> boxes);
+		void clear();
+
+		// nearest primitive box hit within [0, t_max], primitive is ray_hit::no_hit if there is none
+		ray_hit raycast(const ray& r) const;
+		// Batched raycast, four rays are traversed together (best for coherent rays, e.g. neighbouring pixels).
+		// hits needs at least as many entries as rays.
+		void raycast(std::span<const ray> rays, std::span<ray_hit> hits) const;
+		// appends the primitives whose boxes intersect the frustum (conservatively, like cull::intersects_aabb)
+		void query_frustum(const cull::frustum& f, std::vector<uint32_t>& primitives) const;
+		// appends the primitives whose boxes overlap box
+		void query_aabb(const aabb& box, std::vector<uint32_t>& primitives) const;
+
+		std::span<const node> get_nodes() const;
+		std::size_t get_primitive_count() const;
+		uint32_t get_depth() const;
+
+	private:
+		std::vector<node> _nodes;
+		// primitive of every leaf slot, leaves reference contiguous ranges of it
+		std::vector<uint32_t> _primitives;
+		// boxes in leaf slot order, so leaves read them sequentially
+		std::vector<aabb> _boxes;
+		uint32_t _depth = 0;
+
+		// box, centroid and input index of every primitive during the build
+		struct build_primitive
+		{
+			aabb box;
+			vec3f centroid;
+			uint32_t index;
+		};
+
+		uint32_t build_node(std::vector<build_primitive>& primitives, uint32_t first, uint32_t count, uint32_t depth);
+	};
+}
+
+#endif
\ No newline at end of file
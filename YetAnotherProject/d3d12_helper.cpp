@@ -2,7 +2,8 @@
 
 #include "Helper.hpp"
 
-#include "ConstantBuffer.hpp"
+#include <stdexcept>
+#include <vector>
 
 ComPtr<ID3D12Device> create_device(IDXGIFactory4* factory)
 {
@@ -170,17 +171,42 @@ ComPtr<ID3D12DescriptorHeap> create_descriptor_heap(ID3D12Device* device, UINT n
     return heap;
 }
 
-void create_constant_buffer_view(ID3D12Device* device, ConstantBufferBase* const_buffer)
-{
-    // TODO: maybe introduce proper parameter null checking!
-    D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-    cbvDesc.BufferLocation = const_buffer->get_buffer()->GetGPUVirtualAddress();
-    cbvDesc.SizeInBytes = const_buffer->get_size();
-    device->CreateConstantBufferView(&cbvDesc, const_buffer->get_desc_heap()->GetCPUDescriptorHandleForHeapStart());
+namespace {
+    D3D12_SHADER_VISIBILITY to_d3d12(RootSignatureLayout::Visibility visibility)
+    {
+        switch (visibility)
+        {
+        case RootSignatureLayout::Visibility::vertex: return D3D12_SHADER_VISIBILITY_VERTEX;
+        case RootSignatureLayout::Visibility::pixel: return D3D12_SHADER_VISIBILITY_PIXEL;
+        default: return D3D12_SHADER_VISIBILITY_ALL;
+        }
+    }
+
+    D3D12_DESCRIPTOR_RANGE_TYPE to_d3d12(RootSignatureLayout::DescriptorType type)
+    {
+        switch (type)
+        {
+        case RootSignatureLayout::DescriptorType::cbv: return D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
+        case RootSignatureLayout::DescriptorType::srv: return D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        case RootSignatureLayout::DescriptorType::uav: return D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+        default: return D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
+        }
+    }
 }
 
-ComPtr<ID3D12RootSignature> create_default_root_signature(ID3D12Device* device)
+ComPtr<ID3D12RootSignature> create_root_signature(ID3D12Device* device, const RootSignatureLayout& layout)
 {
+    const auto errors = layout.validate();
+    if (!errors.empty())
+    {
+        std::string message = "create_root_signature: invalid layout";
+        for (const auto& error : errors)
+        {
+            message += "\n" + error;
+        }
+        throw std::invalid_argument(message);
+    }
+
     ComPtr<ID3D12RootSignature> root_signature;
     D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
 
@@ -192,14 +218,56 @@ ComPtr<ID3D12RootSignature> create_default_root_signature(ID3D12Device* device)
         featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
     }
 
-    CD3DX12_DESCRIPTOR_RANGE1 ranges[1];
-    CD3DX12_ROOT_PARAMETER1 rootParameters[1];
-    ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
-    rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_VERTEX);
-        
+    const auto& parameters = layout.get_parameters();
+    std::vector<CD3DX12_ROOT_PARAMETER1> root_parameters(parameters.size());
+    // the ranges are referenced by the parameters, so they are kept alive until serialization
+    std::vector<std::vector<CD3DX12_DESCRIPTOR_RANGE1> > table_ranges(parameters.size());
+
+    for (std::size_t p = 0; p < parameters.size(); p++)
+    {
+        const auto& parameter = parameters[p];
+        const auto visibility = to_d3d12(parameter.visibility);
+
+        switch (parameter.type)
+        {
+        case RootSignatureLayout::ParameterType::constants:
+            root_parameters[p].InitAsConstants(parameter.constant_count, parameter.shader_register, parameter.space, visibility);
+            break;
+
+        case RootSignatureLayout::ParameterType::descriptor:
+            // the data behind the address is written before the draw is recorded and never changed afterwards
+            if (parameter.descriptor_type == RootSignatureLayout::DescriptorType::cbv)
+            {
+                root_parameters[p].InitAsConstantBufferView(parameter.shader_register, parameter.space, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, visibility);
+            }
+            else if (parameter.descriptor_type == RootSignatureLayout::DescriptorType::srv)
+            {
+                root_parameters[p].InitAsShaderResourceView(parameter.shader_register, parameter.space, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, visibility);
+            }
+            else
+            {
+                root_parameters[p].InitAsUnorderedAccessView(parameter.shader_register, parameter.space, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, visibility);
+            }
+            break;
 
+        case RootSignatureLayout::ParameterType::table:
+            for (const auto& range : parameter.ranges)
+            {
+                const UINT count = range.count == RootSignatureLayout::unbounded ? UINT_MAX : range.count;
+                // same as root descriptors, uavs are written by the gpu and sampler ranges don't support data flags
+                const bool data_static = range.type == RootSignatureLayout::DescriptorType::cbv || range.type == RootSignatureLayout::DescriptorType::srv;
+                const auto flags = data_static ? D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC : D3D12_DESCRIPTOR_RANGE_FLAG_NONE;
+                table_ranges[p].emplace_back();
+                table_ranges[p].back().Init(to_d3d12(range.type), count, range.base_register, range.space, flags);
+            }
+            root_parameters[p].InitAsDescriptorTable(static_cast<UINT>(table_ranges[p].size()), table_ranges[p].data(), visibility);
+            break;
+        }
+    }
+
+    const auto flags = layout.get_allow_input_layout() ? D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT : D3D12_ROOT_SIGNATURE_FLAG_NONE;
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-    rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+    rootSignatureDesc.Init_1_1(static_cast<UINT>(root_parameters.size()), root_parameters.data(), 0, nullptr, flags);
 
     ComPtr<ID3DBlob> signature;
     ComPtr<ID3DBlob> error;
@@ -208,4 +276,49 @@ ComPtr<ID3D12RootSignature> create_default_root_signature(ID3D12Device* device)
     NAME_D3D12_OBJECT(root_signature);
 
     return root_signature;
+}
+
+ComPtr<ID3D12RootSignature> create_default_root_signature(ID3D12Device* device)
+{
+    return create_root_signature(device, RootSignatureLayout::default_layout());
+}
+
+D3D12FenceTimeline::D3D12FenceTimeline(ID3D12Device* device, ID3D12CommandQueue* command_queue)
+    : _command_queue(command_queue),
+    _fence_event(nullptr)
+{
+    throw_if_failed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&_fence)));
+
+    // Create an event handle to use for frame synchronization.
+    _fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (_fence_event == nullptr)
+    {
+        throw_if_failed(HRESULT_FROM_WIN32(GetLastError()));
+    }
+}
+
+D3D12FenceTimeline::~D3D12FenceTimeline()
+{
+    CloseHandle(_fence_event);
+}
+
+void D3D12FenceTimeline::signal(uint64_t value)
+{
+    throw_if_failed(_command_queue->Signal(_fence.Get(), value));
+}
+
+uint64_t D3D12FenceTimeline::get_completed_value() const
+{
+    return _fence->GetCompletedValue();
+}
+
+void D3D12FenceTimeline::wait_for(uint64_t value)
+{
+    if (_fence->GetCompletedValue() >= value)
+    {
+        return;
+    }
+
+    throw_if_failed(_fence->SetEventOnCompletion(value, _fence_event));
+    WaitForSingleObjectEx(_fence_event, INFINITE, FALSE);
 }
\ No newline at end of file
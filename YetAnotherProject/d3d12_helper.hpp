@@ -8,8 +8,8 @@ using namespace Microsoft::WRL;
 #include <dxgi1_6.h>
 #include <string>
 #include "d3dx12.h"
-
-class ConstantBufferBase;
+#include "FrameFence.hpp"
+#include "RootSignatureLayout.hpp"
 
 // These functions are only as generic as they need to be for the current use cases. I.e. mostly for a convinient way of wrapping the call with all the parameters into a function.
 // be aware of hardcoded flags and types set in descriptor parameters!!
@@ -22,10 +22,31 @@ ComPtr<ID3D12DescriptorHeap> create_rtv_heap(ID3D12Device* device, UINT frame_co
 ComPtr<ID3D12CommandAllocator> create_command_allocator(ID3D12Device* device);
 ComPtr<ID3D12Resource> create_commited_resource(ID3D12Device* device, UINT64 width);
 ComPtr<ID3D12DescriptorHeap> create_descriptor_heap(ID3D12Device* device, UINT num_heaps, D3D12_DESCRIPTOR_HEAP_TYPE type, D3D12_DESCRIPTOR_HEAP_FLAGS flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE);
-void create_constant_buffer_view(ID3D12Device* device, ConstantBufferBase* const_buffer);
-// Default root signature initializes a const buffer that is only visible to the vertex shader at slot 0
+// throws std::invalid_argument with the problems of the layout if it is not valid
+ComPtr<ID3D12RootSignature> create_root_signature(ID3D12Device* device, const RootSignatureLayout& layout);
+// RootSignatureLayout::default_layout, a root cbv at b0 that is only visible to the vertex shader, i.e. set by gpu address without descriptor heap
 ComPtr<ID3D12RootSignature> create_default_root_signature(ID3D12Device* device);
 
+// Fence timeline of a command queue for FrameFence, signals are enqueued on the queue and waited for with an event.
+class D3D12FenceTimeline : public FrameFence::Timeline
+{
+public:
+    D3D12FenceTimeline(ID3D12Device* device, ID3D12CommandQueue* command_queue);
+    ~D3D12FenceTimeline() override;
+
+    D3D12FenceTimeline(const D3D12FenceTimeline&) = delete;
+    D3D12FenceTimeline& operator = (const D3D12FenceTimeline&) = delete;
+
+    void signal(uint64_t value) override;
+    uint64_t get_completed_value() const override;
+    void wait_for(uint64_t value) override;
+
+private:
+    ID3D12CommandQueue* _command_queue;
+    ComPtr<ID3D12Fence> _fence;
+    HANDLE _fence_event;
+};
+
 // From DXSample(s)
 // Assign a name to the object to aid with debugging.
 #if defined(_DEBUG) || defined(DBG)
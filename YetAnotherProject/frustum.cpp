@@ -0,0 +1,175 @@
+#include "frustum.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include "simd.hpp"
+
+using namespace simd;
+
+namespace cull {
+	namespace {
+		vec4f normalize_plane(const vec4f& p)
+		{
+			const float inv_length = 1.0f / std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+			return p * inv_length;
+		}
+
+		float plane_distance(const vec4f& p, const vec3f& point)
+		{
+			return p.x * point.x + p.y * point.y + p.z * point.z + p.w;
+		}
+
+		// writes first_index + lane for every set bit of the mask
+		std::size_t compact(int mask, uint32_t first_index, uint32_t* out)
+		{
+			std::size_t count = 0;
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				out[count] = first_index + lane;
+				count += (mask >> lane) & 1;
+			}
+			return count;
+		}
+	}
+
+	frustum extract_frustum(const mat4f& m)
+	{
+		// clip = m * v, so every plane is a combination of the rows of m
+		const vec4f r0(m[0][0], m[0][1], m[0][2], m[0][3]);
+		const vec4f r1(m[1][0], m[1][1], m[1][2], m[1][3]);
+		const vec4f r2(m[2][0], m[2][1], m[2][2], m[2][3]);
+		const vec4f r3(m[3][0], m[3][1], m[3][2], m[3][3]);
+
+		frustum f;
+		f.planes[frustum::left] = normalize_plane(r3 + r0);
+		f.planes[frustum::right] = normalize_plane(r3 - r0);
+		f.planes[frustum::bottom] = normalize_plane(r3 + r1);
+		f.planes[frustum::top] = normalize_plane(r3 - r1);
+		f.planes[frustum::near_plane] = normalize_plane(r2);
+		f.planes[frustum::far_plane] = normalize_plane(r3 - r2);
+		return f;
+	}
+
+	bool intersects_sphere(const frustum& f, const vec3f& center, float radius)
+	{
+		for (const auto& p : f.planes)
+		{
+			if (plane_distance(p, center) < -radius)
+				return false;
+		}
+		return true;
+	}
+
+	bool intersects_aabb(const frustum& f, const vec3f& center, const vec3f& extent)
+	{
+		for (const auto& p : f.planes)
+		{
+			// projected extent of the box onto the plane normal
+			const float radius = std::fabs(p.x) * extent.x + std::fabs(p.y) * extent.y + std::fabs(p.z) * extent.z;
+			if (plane_distance(p, center) < -radius)
+				return false;
+		}
+		return true;
+	}
+
+	std::size_t cull_spheres(const frustum& f, const sphere_soa& spheres, std::span<uint32_t> visible, uint32_t first_index)
+	{
+		const std::size_t count = spheres.x.size();
+		if (spheres.y.size() != count || spheres.z.size() != count || spheres.radius.size() != count)
+		{
+			throw std::invalid_argument("cull::cull_spheres: soa spans differ in size");
+		}
+		if (visible.size() < count)
+		{
+			throw std::invalid_argument("cull::cull_spheres: visible is too small");
+		}
+
+		float4 planes[frustum::plane_count][4];
+		for (int p = 0; p < frustum::plane_count; ++p)
+			for (int c = 0; c < 4; ++c)
+				planes[p][c] = set1(f.planes[p].data[c]);
+
+		std::size_t visible_count = 0;
+		std::size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float4 x = load(&spheres.x[i]);
+			const float4 y = load(&spheres.y[i]);
+			const float4 z = load(&spheres.z[i]);
+			const float4 neg_radius = -load(&spheres.radius[i]);
+
+			int mask = 0xF;
+			for (int p = 0; p < frustum::plane_count && mask; ++p)
+			{
+				const float4 distance = planes[p][0] * x + planes[p][1] * y + planes[p][2] * z + planes[p][3];
+				mask &= mask_bits(distance >= neg_radius);
+			}
+
+			visible_count += compact(mask, first_index + static_cast<uint32_t>(i), &visible[visible_count]);
+		}
+
+		for (; i < count; ++i)
+		{
+			if (intersects_sphere(f, vec3f(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i]))
+				visible[visible_count++] = first_index + static_cast<uint32_t>(i);
+		}
+
+		return visible_count;
+	}
+
+	std::size_t cull_aabbs(const frustum& f, const aabb_soa& boxes, std::span<uint32_t> visible, uint32_t first_index)
+	{
+		const std::size_t count = boxes.center_x.size();
+		if (boxes.center_y.size() != count || boxes.center_z.size() != count ||
+			boxes.extent_x.size() != count || boxes.extent_y.size() != count || boxes.extent_z.size() != count)
+		{
+			throw std::invalid_argument("cull::cull_aabbs: soa spans differ in size");
+		}
+		if (visible.size() < count)
+		{
+			throw std::invalid_argument("cull::cull_aabbs: visible is too small");
+		}
+
+		float4 planes[frustum::plane_count][4];
+		float4 abs_normals[frustum::plane_count][3];
+		for (int p = 0; p < frustum::plane_count; ++p)
+		{
+			for (int c = 0; c < 4; ++c)
+				planes[p][c] = set1(f.planes[p].data[c]);
+			for (int c = 0; c < 3; ++c)
+				abs_normals[p][c] = set1(std::fabs(f.planes[p].data[c]));
+		}
+
+		std::size_t visible_count = 0;
+		std::size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float4 cx = load(&boxes.center_x[i]);
+			const float4 cy = load(&boxes.center_y[i]);
+			const float4 cz = load(&boxes.center_z[i]);
+			const float4 ex = load(&boxes.extent_x[i]);
+			const float4 ey = load(&boxes.extent_y[i]);
+			const float4 ez = load(&boxes.extent_z[i]);
+
+			int mask = 0xF;
+			for (int p = 0; p < frustum::plane_count && mask; ++p)
+			{
+				const float4 distance = planes[p][0] * cx + planes[p][1] * cy + planes[p][2] * cz + planes[p][3];
+				const float4 radius = abs_normals[p][0] * ex + abs_normals[p][1] * ey + abs_normals[p][2] * ez;
+				mask &= mask_bits(distance + radius >= set1(0.0f));
+			}
+
+			visible_count += compact(mask, first_index + static_cast<uint32_t>(i), &visible[visible_count]);
+		}
+
+		for (; i < count; ++i)
+		{
+			const vec3f center(boxes.center_x[i], boxes.center_y[i], boxes.center_z[i]);
+			const vec3f extent(boxes.extent_x[i], boxes.extent_y[i], boxes.extent_z[i]);
+			if (intersects_aabb(f, center, extent))
+				visible[visible_count++] = first_index + static_cast<uint32_t>(i);
+		}
+
+		return visible_count;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef FRUSTUM_INCLUDED
+#define FRUSTUM_INCLUDED
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include "vec.hpp"
+#include "mat4.hpp"
+
+namespace cull {
+	// Planes are stored as (normal, d) with the normal pointing inside, a point p is inside when dot(normal, p) + d >= 0.
+	struct frustum
+	{
+		enum plane_index { left, right, bottom, top, near_plane, far_plane, plane_count };
+		std::array<vec4f, plane_count> planes;
+	};
+
+	// Structure of arrays views over the bounding volumes, all spans must have the same size.
+	struct sphere_soa
+	{
+		std::span<const float> x, y, z, radius;
+	};
+
+	struct aabb_soa
+	{
+		std::span<const float> center_x, center_y, center_z;
+		std::span<const float> extent_x, extent_y, extent_z;
+	};
+
+	// Extracts the normalized planes of a view projection matrix, e.g. mat::proj(...) * mat::look_at(...).
+	// Expects the d3d clip space (0 <= z <= w).
+	frustum extract_frustum(const mat4f& view_proj);
+
+	bool intersects_sphere(const frustum& f, const vec3f& center, float radius);
+	bool intersects_aabb(const frustum& f, const vec3f& center, const vec3f& extent);
+
+	// Batched culling, four volumes per iteration. Writes the indices of the visible volumes
+	// (offset by first_index) compacted to visible and returns how many there are.
+	// visible must be at least as large as the number of volumes.
+	std::size_t cull_spheres(const frustum& f, const sphere_soa& spheres, std::span<uint32_t> visible, uint32_t first_index = 0);
+	std::size_t cull_aabbs(const frustum& f, const aabb_soa& boxes, std::span<uint32_t> visible, uint32_t first_index = 0);
+}
+
+#endif
\ No newline at end of file
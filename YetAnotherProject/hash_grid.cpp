@@ -0,0 +1,296 @@
+#include "hash_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "JobSystem.hpp"
+
+namespace spatial {
+	namespace {
+		bool overlaps(const aabb& a, const aabb& b)
+		{
+			return a.min.x <= b.max.x && b.min.x <= a.max.x
+				&& a.min.y <= b.max.y && b.min.y <= a.max.y
+				&& a.min.z <= b.max.z && b.min.z <= a.max.z;
+		}
+	}
+
+	bool hash_grid::cell_range::contains(int32_t x, int32_t y, int32_t z) const
+	{
+		return x >= min[0] && x <= max[0] && y >= min[1] && y <= max[1] && z >= min[2] && z <= max[2];
+	}
+
+	hash_grid::hash_grid(float cell_size)
+		: _cell_size(cell_size),
+		_inv_cell_size(1.0f / cell_size),
+		_proxy_count(0)
+	{
+		if (!(cell_size > 0.0f))
+			throw std::invalid_argument("spatial::hash_grid: cell size must be positive");
+	}
+
+	int32_t hash_grid::cell_coordinate(float value) const
+	{
+		// clamped, far away bodies share the outermost cells instead of overflowing
+		constexpr float limit = 1 << 30;
+		return static_cast<int32_t>(std::floor(std::clamp(value * _inv_cell_size, -limit, limit)));
+	}
+
+	hash_grid::cell_range hash_grid::get_cell_range(const aabb& box) const
+	{
+		cell_range range;
+		for (int i = 0; i < 3; ++i)
+		{
+			range.min[i] = cell_coordinate(box.min[i]);
+			range.max[i] = cell_coordinate(box.max[i]);
+		}
+		return range;
+	}
+
+	// 21 bits per axis, cells 2^21 apart share a key which only costs some extra overlap tests
+	uint64_t hash_grid::get_key(int32_t x, int32_t y, int32_t z)
+	{
+		constexpr uint64_t mask = (1ull << 21) - 1;
+		return (static_cast<uint64_t>(x) & mask) | ((static_cast<uint64_t>(y) & mask) << 21) | ((static_cast<uint64_t>(z) & mask) << 42);
+	}
+
+	void hash_grid::add_to_cell(uint64_t key, uint32_t proxy_index)
+	{
+		auto it = _cell_indices.find(key);
+		if (it == _cell_indices.end())
+		{
+			uint32_t cell_index;
+			if (!_free_cells.empty())
+			{
+				cell_index = _free_cells.back();
+				_free_cells.pop_back();
+			}
+			else
+			{
+				cell_index = static_cast<uint32_t>(_cells.size());
+				_cells.emplace_back();
+			}
+
+			_cells[cell_index].key = key;
+			it = _cell_indices.emplace(key, cell_index).first;
+		}
+
+		_cells[it->second].proxies.push_back(proxy_index);
+	}
+
+	void hash_grid::remove_from_cell(uint64_t key, uint32_t proxy_index)
+	{
+		const auto it = _cell_indices.find(key);
+		if (it == _cell_indices.end())
+			return;
+
+		cell& c = _cells[it->second];
+		const auto entry = std::find(c.proxies.begin(), c.proxies.end(), proxy_index);
+		if (entry != c.proxies.end())
+		{
+			*entry = c.proxies.back();
+			c.proxies.pop_back();
+		}
+
+		// keeps its memory for the next body moving into a cell
+		if (c.proxies.empty())
+		{
+			_free_cells.push_back(it->second);
+			_cell_indices.erase(it);
+		}
+	}
+
+	void hash_grid::check_proxy(uint32_t proxy_index) const
+	{
+		if (proxy_index >= _proxies.size() || !_proxies[proxy_index].alive)
+			throw std::invalid_argument("spatial::hash_grid: unknown proxy");
+	}
+
+	uint32_t hash_grid::insert(const aabb& box)
+	{
+		uint32_t proxy_index;
+		if (!_free_proxies.empty())
+		{
+			proxy_index = _free_proxies.back();
+			_free_proxies.pop_back();
+		}
+		else
+		{
+			proxy_index = static_cast<uint32_t>(_proxies.size());
+			_proxies.emplace_back();
+		}
+
+		proxy& p = _proxies[proxy_index];
+		p.box = box;
+		p.cells = get_cell_range(box);
+		p.alive = true;
+		_proxy_count++;
+
+		for (int32_t z = p.cells.min[2]; z <= p.cells.max[2]; ++z)
+			for (int32_t y = p.cells.min[1]; y <= p.cells.max[1]; ++y)
+				for (int32_t x = p.cells.min[0]; x <= p.cells.max[0]; ++x)
+					add_to_cell(get_key(x, y, z), proxy_index);
+
+		return proxy_index;
+	}
+
+	void hash_grid::move(uint32_t proxy_index, const aabb& box)
+	{
+		check_proxy(proxy_index);
+
+		proxy& p = _proxies[proxy_index];
+		const cell_range old_cells = p.cells;
+		const cell_range new_cells = get_cell_range(box);
+		p.box = box;
+
+		// most moves stay within the same cells
+		if (old_cells == new_cells)
+			return;
+
+		p.cells = new_cells;
+
+		for (int32_t z = old_cells.min[2]; z <= old_cells.max[2]; ++z)
+			for (int32_t y = old_cells.min[1]; y <= old_cells.max[1]; ++y)
+				for (int32_t x = old_cells.min[0]; x <= old_cells.max[0]; ++x)
+					if (!new_cells.contains(x, y, z))
+						remove_from_cell(get_key(x, y, z), proxy_index);
+
+		for (int32_t z = new_cells.min[2]; z <= new_cells.max[2]; ++z)
+			for (int32_t y = new_cells.min[1]; y <= new_cells.max[1]; ++y)
+				for (int32_t x = new_cells.min[0]; x <= new_cells.max[0]; ++x)
+					if (!old_cells.contains(x, y, z))
+						add_to_cell(get_key(x, y, z), proxy_index);
+	}
+
+	void hash_grid::remove(uint32_t proxy_index)
+	{
+		check_proxy(proxy_index);
+
+		proxy& p = _proxies[proxy_index];
+		for (int32_t z = p.cells.min[2]; z <= p.cells.max[2]; ++z)
+			for (int32_t y = p.cells.min[1]; y <= p.cells.max[1]; ++y)
+				for (int32_t x = p.cells.min[0]; x <= p.cells.max[0]; ++x)
+					remove_from_cell(get_key(x, y, z), proxy_index);
+
+		p.alive = false;
+		_free_proxies.push_back(proxy_index);
+		_proxy_count--;
+	}
+
+	void hash_grid::clear()
+	{
+		_proxies.clear();
+		_free_proxies.clear();
+		_proxy_count = 0;
+		_cells.clear();
+		_free_cells.clear();
+		_cell_indices.clear();
+	}
+
+	// Two bodies sharing several cells would be found in each of them. A pair is only reported by the
+	// cell containing the minimum corner of the overlap of both boxes, which both bodies are registered in.
+	void hash_grid::find_cell_pairs(const cell& c, std::vector<pair>& pairs) const
+	{
+		const std::size_t count = c.proxies.size();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const uint32_t a = c.proxies[i];
+			const aabb& box_a = _proxies[a].box;
+
+			for (std::size_t j = i + 1; j < count; ++j)
+			{
+				const uint32_t b = c.proxies[j];
+				const aabb& box_b = _proxies[b].box;
+				if (!overlaps(box_a, box_b))
+					continue;
+
+				const uint64_t owner = get_key(
+					cell_coordinate(std::max(box_a.min.x, box_b.min.x)),
+					cell_coordinate(std::max(box_a.min.y, box_b.min.y)),
+					cell_coordinate(std::max(box_a.min.z, box_b.min.z)));
+				if (owner == c.key)
+					pairs.push_back({ std::min(a, b), std::max(a, b) });
+			}
+		}
+	}
+
+	void hash_grid::find_pairs(std::vector<pair>& pairs, JobSystem* job_system, std::size_t grain_size) const
+	{
+		pairs.clear();
+		grain_size = std::max<std::size_t>(grain_size, 1);
+
+		if (!job_system || _cells.size() <= grain_size)
+		{
+			for (const cell& c : _cells)
+				find_cell_pairs(c, pairs);
+			return;
+		}
+
+		// every chunk of cells collects into its own array, they are appended in chunk order
+		std::vector<std::vector<pair> > chunk_pairs((_cells.size() + grain_size - 1) / grain_size);
+		job_system->parallel_for(0, _cells.size(), grain_size, [&](std::size_t first, std::size_t last)
+		{
+			std::vector<pair>& out = chunk_pairs[first / grain_size];
+			for (std::size_t i = first; i < last; ++i)
+				find_cell_pairs(_cells[i], out);
+		});
+
+		std::size_t total = 0;
+		for (const auto& chunk : chunk_pairs)
+			total += chunk.size();
+
+		pairs.reserve(total);
+		for (const auto& chunk : chunk_pairs)
+			pairs.insert(pairs.end(), chunk.begin(), chunk.end());
+	}
+
+	void hash_grid::query(const aabb& box, std::vector<uint32_t>& proxies) const
+	{
+		const cell_range range = get_cell_range(box);
+		for (int32_t z = range.min[2]; z <= range.max[2]; ++z)
+			for (int32_t y = range.min[1]; y <= range.max[1]; ++y)
+				for (int32_t x = range.min[0]; x <= range.max[0]; ++x)
+				{
+					const uint64_t key = get_key(x, y, z);
+					const auto it = _cell_indices.find(key);
+					if (it == _cell_indices.end())
+						continue;
+
+					for (const uint32_t proxy_index : _cells[it->second].proxies)
+					{
+						const aabb& other = _proxies[proxy_index].box;
+						if (!overlaps(box, other))
+							continue;
+
+						// same rule as find_cell_pairs, reported by one cell only
+						const uint64_t owner = get_key(
+							cell_coordinate(std::max(box.min.x, other.min.x)),
+							cell_coordinate(std::max(box.min.y, other.min.y)),
+							cell_coordinate(std::max(box.min.z, other.min.z)));
+						if (owner == key)
+							proxies.push_back(proxy_index);
+					}
+				}
+	}
+
+	const aabb& hash_grid::get_box(uint32_t proxy_index) const
+	{
+		check_proxy(proxy_index);
+		return _proxies[proxy_index].box;
+	}
+
+	float hash_grid::get_cell_size() const
+	{
+		return _cell_size;
+	}
+
+	std::size_t hash_grid::get_proxy_count() const
+	{
+		return _proxy_count;
+	}
+
+	std::size_t hash_grid::get_cell_count() const
+	{
+		return _cell_indices.size();
+	}
+}
\ No newline at end of file
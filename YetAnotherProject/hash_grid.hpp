@@ -0,0 +1,100 @@
+#ifndef HASH_GRID_INCLUDED
+#define HASH_GRID_INCLUDED
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "bvh.hpp"
+
+class JobSystem;
+
+namespace spatial {
+	// Collision broadphase: a uniform grid of cubic cells, where only occupied cells exist (in a hash map).
+	// Every body is registered in all cells its box touches. Moving a body only touches the grid when it
+	// crosses into other cells, so a step with n moving bodies costs O(n) as long as the cell size is in
+	// the order of the typical body size (bodies much larger than a cell register in many cells).
+	class hash_grid
+	{
+	public:
+		static constexpr uint32_t invalid_proxy = UINT32_MAX;
+		// cells per job in find_pairs
+		static constexpr std::size_t default_grain_size = 256;
+
+		// candidate pair, a < b
+		struct pair
+		{
+			uint32_t a;
+			uint32_t b;
+
+			bool operator == (const pair&) const = default;
+		};
+
+		explicit hash_grid(float cell_size);
+
+		// returns the proxy id of the body, ids of removed bodies are reused
+		uint32_t insert(const aabb& box);
+		// throws std::invalid_argument for unknown proxies
+		void move(uint32_t proxy, const aabb& box);
+		void remove(uint32_t proxy);
+		void clear();
+
+		// Replaces pairs with every pair of bodies whose boxes overlap, each pair exactly once. Cells are split
+		// across the job system if there is one, the order of the pairs doesn't depend on it.
+		void find_pairs(std::vector<pair>& pairs, JobSystem* job_system = nullptr, std::size_t grain_size = default_grain_size) const;
+		// appends the bodies whose boxes overlap box, each once
+		void query(const aabb& box, std::vector<uint32_t>& proxies) const;
+
+		const aabb& get_box(uint32_t proxy) const;
+		float get_cell_size() const;
+		std::size_t get_proxy_count() const;
+		std::size_t get_cell_count() const;
+
+	private:
+		struct cell_range
+		{
+			int32_t min[3];
+			int32_t max[3];
+
+			bool contains(int32_t x, int32_t y, int32_t z) const;
+			bool operator == (const cell_range&) const = default;
+		};
+
+		struct proxy
+		{
+			aabb box;
+			cell_range cells;
+			bool alive;
+		};
+
+		struct cell
+		{
+			uint64_t key;
+			std::vector<uint32_t> proxies;
+		};
+
+		float _cell_size;
+		float _inv_cell_size;
+
+		std::vector<proxy> _proxies;
+		std::vector<uint32_t> _free_proxies;
+		std::size_t _proxy_count;
+
+		// occupied cells are kept dense for find_pairs, emptied ones are recycled
+		std::vector<cell> _cells;
+		std::vector<uint32_t> _free_cells;
+		std::unordered_map<uint64_t, uint32_t> _cell_indices;
+
+		int32_t cell_coordinate(float value) const;
+		cell_range get_cell_range(const aabb& box) const;
+		static uint64_t get_key(int32_t x, int32_t y, int32_t z);
+
+		void add_to_cell(uint64_t key, uint32_t proxy_index);
+		void remove_from_cell(uint64_t key, uint32_t proxy_index);
+		void check_proxy(uint32_t proxy_index) const;
+		void find_cell_pairs(const cell& c, std::vector<pair>& pairs) const;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,70 +1,298 @@
 #include "mat4.hpp"
 
+#include <stdexcept>
 #include "vec.hpp"
+#include "simd.hpp"
 #include "utility.hpp"
 
 using namespace vec;
 
 namespace mat {
-	mat4f zeroed() {
-		mat4f m;
-		m[0][0] = 0; m[0][1] = 0; m[0][2] = 0; m[0][3] = 0;
-		m[1][0] = 0; m[1][1] = 0; m[1][2] = 0; m[1][3] = 0;
-		m[2][0] = 0; m[2][1] = 0; m[2][2] = 0; m[2][3] = 0;
-		m[3][0] = 0; m[3][1] = 0; m[3][2] = 0; m[3][3] = 0;
-		return m;
-	}
-
-	mat4f identity() {
-		mat4f m;
-		m[0][0] = 1; m[0][1] = 0; m[0][2] = 0; m[0][3] = 0;
-		m[1][0] = 0; m[1][1] = 1; m[1][2] = 0; m[1][3] = 0;
-		m[2][0] = 0; m[2][1] = 0; m[2][2] = 1; m[2][3] = 0;
-		m[3][0] = 0; m[3][1] = 0; m[3][2] = 0; m[3][3] = 1;
-		return m;
-	}
-
-	mat4f multiply(const mat4f& lhs, const mat4f& rhs) {
+	mat4f detail::multiply_kernel(const mat4f& lhs, const mat4f& rhs) {
 		mat4f resultMatrix;
 
-		const auto testA = lhs[3];
+#if defined(SIMD_AVX2)
+		// every row of the result is a linear combination of the rows of rhs, two result rows are computed per iteration
+		const __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs[0].data()));
+		const __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs[1].data()));
+		const __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs[2].data()));
+		const __m256 r3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs[3].data()));
+
+		for (int i = 0; i < 4; i += 2)
+		{
+			const __m256 a = _mm256_loadu_ps(lhs[i].data());
+			__m256 row = _mm256_mul_ps(_mm256_permute_ps(a, 0x00), r0);
+			row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_permute_ps(a, 0x55), r1));
+			row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_permute_ps(a, 0xAA), r2));
+			row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_permute_ps(a, 0xFF), r3));
+			_mm256_storeu_ps(resultMatrix[i].data(), row);
+		}
+#elif defined(SIMD_SSE2)
+		// every row of the result is a linear combination of the rows of rhs
+		const __m128 r0 = _mm_loadu_ps(rhs[0].data());
+		const __m128 r1 = _mm_loadu_ps(rhs[1].data());
+		const __m128 r2 = _mm_loadu_ps(rhs[2].data());
+		const __m128 r3 = _mm_loadu_ps(rhs[3].data());
 
+		for (int i = 0; i < 4; i++)
+		{
+			__m128 row = _mm_mul_ps(_mm_set1_ps(lhs[i][0]), r0);
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs[i][1]), r1));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs[i][2]), r2));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs[i][3]), r3));
+			_mm_storeu_ps(resultMatrix[i].data(), row);
+		}
+#else
 		for (int i = 0; i < 4; i++)
 		{
 			for (int j = 0; j < 4; j++)
 			{
-				resultMatrix[i][j] = 0;
+				// accumulate locally, writing through resultMatrix would force a store per k
+				float sum = 0.0f;
 				for (int k = 0; k < 4; k++)
 				{
-					resultMatrix[i][j] += lhs[i][k] * rhs[k][j];
+					sum += lhs[i][k] * rhs[k][j];
 				}
+				resultMatrix[i][j] = sum;
 			}
 		}
+#endif
 
 		return resultMatrix;
 	}
 
-	vec4f multiply(const mat4f& mat, const vec4f& vec) {
+	vec4f detail::multiply_kernel(const mat4f& mat, const vec4f& vec) {
+#if defined(SIMD_SSE2)
+		const __m128 v = _mm_load_ps(vec.data);
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(mat[0].data()), v);
+		__m128 y = _mm_mul_ps(_mm_loadu_ps(mat[1].data()), v);
+		__m128 z = _mm_mul_ps(_mm_loadu_ps(mat[2].data()), v);
+		__m128 w = _mm_mul_ps(_mm_loadu_ps(mat[3].data()), v);
+
+		// transpose the products so the four dot products are summed up vertically
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		return vec4f(_mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w)));
+#else
 		vec4f result;
 		result.x = mat[0][0] * vec.x + mat[0][1] * vec.y + mat[0][2] * vec.z + mat[0][3] * vec.w;
 		result.y = mat[1][0] * vec.x + mat[1][1] * vec.y + mat[1][2] * vec.z + mat[1][3] * vec.w;
 		result.z = mat[2][0] * vec.x + mat[2][1] * vec.y + mat[2][2] * vec.z + mat[2][3] * vec.w;
 		result.w = mat[3][0] * vec.x + mat[3][1] * vec.y + mat[3][2] * vec.z + mat[3][3] * vec.w;
 		return result;
+#endif
 	}
 
-	mat4f ortho(float width, float height, float nearPlane, float farPlane) {
-		mat4f result = identity();
+	mat4f detail::transpose_kernel(const mat4f& m)
+	{
+		mat4f result;
+#if defined(SIMD_SSE2)
+		__m128 r0 = _mm_loadu_ps(m[0].data());
+		__m128 r1 = _mm_loadu_ps(m[1].data());
+		__m128 r2 = _mm_loadu_ps(m[2].data());
+		__m128 r3 = _mm_loadu_ps(m[3].data());
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(result[0].data(), r0);
+		_mm_storeu_ps(result[1].data(), r1);
+		_mm_storeu_ps(result[2].data(), r2);
+		_mm_storeu_ps(result[3].data(), r3);
+#else
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				result[i][j] = m[j][i];
+#endif
+		return result;
+	}
+
+#if defined(SIMD_SSE2)
+	namespace {
+		template <int X, int Y, int Z, int W>
+		__m128 swizzle(__m128 v)
+		{
+			return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+		}
+
+		template <int X, int Y, int Z, int W>
+		__m128 shuffle(__m128 a, __m128 b)
+		{
+			return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+		}
+
+		// 2x2 matrices are stored row major in one register: (m00, m01, m10, m11)
+		// a * b
+		__m128 mat2_mul(__m128 a, __m128 b)
+		{
+			return _mm_add_ps(_mm_mul_ps(a, swizzle<0, 3, 0, 3>(b)), _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+		}
+
+		// adjugate(a) * b
+		__m128 mat2_adj_mul(__m128 a, __m128 b)
+		{
+			return _mm_sub_ps(_mm_mul_ps(swizzle<3, 3, 0, 0>(a), b), _mm_mul_ps(swizzle<1, 1, 2, 2>(a), swizzle<2, 3, 0, 1>(b)));
+		}
+
+		// a * adjugate(b)
+		__m128 mat2_mul_adj(__m128 a, __m128 b)
+		{
+			return _mm_sub_ps(_mm_mul_ps(a, swizzle<3, 0, 3, 0>(b)), _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+		}
+
+		__m128 cross3(__m128 a, __m128 b)
+		{
+			return _mm_sub_ps(
+				_mm_mul_ps(swizzle<1, 2, 0, 3>(a), swizzle<2, 0, 1, 3>(b)),
+				_mm_mul_ps(swizzle<2, 0, 1, 3>(a), swizzle<1, 2, 0, 3>(b)));
+		}
+
+		__m128 horizontal_sum(__m128 v)
+		{
+			v = _mm_add_ps(v, swizzle<2, 3, 0, 1>(v));
+			return _mm_add_ps(v, swizzle<1, 0, 3, 2>(v));
+		}
+	}
+#endif
+
+	mat4f inverse(const mat4f& m)
+	{
+		mat4f result;
+#if defined(SIMD_SSE2)
+		// block wise inverse of the four 2x2 sub matrices | A B |
+		//                                                 | C D |
+		const __m128 r0 = _mm_loadu_ps(m[0].data());
+		const __m128 r1 = _mm_loadu_ps(m[1].data());
+		const __m128 r2 = _mm_loadu_ps(m[2].data());
+		const __m128 r3 = _mm_loadu_ps(m[3].data());
+
+		const __m128 a = _mm_movelh_ps(r0, r1);
+		const __m128 b = _mm_movehl_ps(r1, r0);
+		const __m128 c = _mm_movelh_ps(r2, r3);
+		const __m128 d = _mm_movehl_ps(r3, r2);
+
+		// (|A|, |B|, |C|, |D|)
+		const __m128 det_sub = _mm_sub_ps(
+			_mm_mul_ps(shuffle<0, 2, 0, 2>(r0, r2), shuffle<1, 3, 1, 3>(r1, r3)),
+			_mm_mul_ps(shuffle<1, 3, 1, 3>(r0, r2), shuffle<0, 2, 0, 2>(r1, r3)));
+		const __m128 det_a = swizzle<0, 0, 0, 0>(det_sub);
+		const __m128 det_b = swizzle<1, 1, 1, 1>(det_sub);
+		const __m128 det_c = swizzle<2, 2, 2, 2>(det_sub);
+		const __m128 det_d = swizzle<3, 3, 3, 3>(det_sub);
+
+		const __m128 d_c = mat2_adj_mul(d, c);
+		const __m128 a_b = mat2_adj_mul(a, b);
+
+		// adjugates of the blocks of the inverse
+		__m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), mat2_mul(b, d_c));
+		__m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), mat2_mul(c, a_b));
+		__m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), mat2_mul_adj(d, a_b));
+		__m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), mat2_mul_adj(a, d_c));
+
+		// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+		const __m128 trace = horizontal_sum(_mm_mul_ps(a_b, swizzle<0, 2, 1, 3>(d_c)));
+		const __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), trace);
+		const __m128 inv_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+
+		x = _mm_mul_ps(x, inv_det);
+		y = _mm_mul_ps(y, inv_det);
+		z = _mm_mul_ps(z, inv_det);
+		w = _mm_mul_ps(w, inv_det);
+
+		// undo the adjugate while storing the rows
+		_mm_storeu_ps(result[0].data(), shuffle<3, 1, 3, 1>(x, y));
+		_mm_storeu_ps(result[1].data(), shuffle<2, 0, 2, 0>(x, y));
+		_mm_storeu_ps(result[2].data(), shuffle<3, 1, 3, 1>(z, w));
+		_mm_storeu_ps(result[3].data(), shuffle<2, 0, 2, 0>(z, w));
+#else
+		// cofactor expansion over the 2x2 sub determinants of the upper and lower two rows
+		const float s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+		const float s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+		const float s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+		const float s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+		const float s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+		const float s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+		const float c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+		const float c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+		const float c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+		const float c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+		const float c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+		const float c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+		const float inv_det = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+		result[0][0] = ( m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * inv_det;
+		result[0][1] = (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * inv_det;
+		result[0][2] = ( m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * inv_det;
+		result[0][3] = (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * inv_det;
+
+		result[1][0] = (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * inv_det;
+		result[1][1] = ( m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * inv_det;
+		result[1][2] = (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * inv_det;
+		result[1][3] = ( m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * inv_det;
+
+		result[2][0] = ( m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * inv_det;
+		result[2][1] = (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * inv_det;
+		result[2][2] = ( m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * inv_det;
+		result[2][3] = (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * inv_det;
 
-		result[0][0] = 2.0f / width;
-		result[1][1] = 2.0f / height;
-		result[2][2] = 1.0f / (farPlane - nearPlane);
-		result[2][3] = nearPlane / (nearPlane - farPlane);
+		result[3][0] = (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * inv_det;
+		result[3][1] = ( m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * inv_det;
+		result[3][2] = (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * inv_det;
+		result[3][3] = ( m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * inv_det;
+#endif
 		return result;
 	}
 
-	mat4f ortho(const vec2f& dimension, const vec2f& near_far_planes) {
-		return ortho(dimension.x, dimension.y, near_far_planes.x, near_far_planes.y);
+	mat4f affine_inverse(const mat4f& m)
+	{
+		// | A t |^-1   | A^-1  -A^-1 t |
+		// | 0 1 |    = | 0      1      |
+		// the columns of A^-1 are the cross products of the rows of A divided by |A|
+		mat4f result;
+#if defined(SIMD_SSE2)
+		const __m128 xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		const __m128 r0 = _mm_loadu_ps(m[0].data());
+		const __m128 r1 = _mm_loadu_ps(m[1].data());
+		const __m128 r2 = _mm_loadu_ps(m[2].data());
+		const __m128 a0 = _mm_and_ps(r0, xyz_mask);
+		const __m128 a1 = _mm_and_ps(r1, xyz_mask);
+		const __m128 a2 = _mm_and_ps(r2, xyz_mask);
+
+		const __m128 c0 = cross3(a1, a2);
+		const __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), horizontal_sum(_mm_mul_ps(a0, c0)));
+
+		__m128 col0 = _mm_mul_ps(c0, inv_det);
+		__m128 col1 = _mm_mul_ps(cross3(a2, a0), inv_det);
+		__m128 col2 = _mm_mul_ps(cross3(a0, a1), inv_det);
+
+		// -A^-1 t as the fourth column, its w becomes the 1 of the last row
+		__m128 col3 = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(col0, swizzle<3, 3, 3, 3>(r0)), _mm_mul_ps(col1, swizzle<3, 3, 3, 3>(r1))),
+			_mm_mul_ps(col2, swizzle<3, 3, 3, 3>(r2)));
+		col3 = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), col3);
+
+		_MM_TRANSPOSE4_PS(col0, col1, col2, col3);
+		_mm_storeu_ps(result[0].data(), col0);
+		_mm_storeu_ps(result[1].data(), col1);
+		_mm_storeu_ps(result[2].data(), col2);
+		_mm_storeu_ps(result[3].data(), col3);
+#else
+		const vec3f a0(m[0][0], m[0][1], m[0][2]);
+		const vec3f a1(m[1][0], m[1][1], m[1][2]);
+		const vec3f a2(m[2][0], m[2][1], m[2][2]);
+
+		const vec3f c0 = cross(a1, a2);
+		const float inv_det = 1.0f / dot(a0, c0);
+		const vec3f col[3] = { c0 * inv_det, cross(a2, a0) * inv_det, cross(a0, a1) * inv_det };
+
+		for (int i = 0; i < 3; i++)
+		{
+			result[i][0] = col[0][i];
+			result[i][1] = col[1][i];
+			result[i][2] = col[2][i];
+			result[i][3] = -(col[0][i] * m[0][3] + col[1][i] * m[1][3] + col[2][i] * m[2][3]);
+		}
+		result[3] = { 0.0f, 0.0f, 0.0f, 1.0f };
+#endif
+		return result;
 	}
 
 	mat4f rotate_z(float angle_in_rad)
@@ -127,22 +355,158 @@ namespace mat {
 		return m;
 	}
 
-	mat4f translate(const vec3f& v)
+	void transform(const mat4f& m, const soa_points& in, const soa_points_out& out)
 	{
-		mat4f m = identity();
-		m[0][3] = v.x;
-		m[1][3] = v.y;
-		m[2][3] = v.z;
-		return m;
+		const std::size_t count = in.x.size();
+		const bool has_in_w = !in.w.empty();
+		const bool has_out_w = !out.w.empty();
+
+		if (in.y.size() != count || in.z.size() != count || (has_in_w && in.w.size() != count) ||
+			out.x.size() != count || out.y.size() != count || out.z.size() != count || (has_out_w && out.w.size() != count))
+		{
+			throw std::invalid_argument("mat::transform: soa spans differ in size");
+		}
+
+		std::size_t i = 0;
+
+#if defined(SIMD_AVX2)
+		__m256 c[4][4];
+		for (int r = 0; r < 4; ++r)
+			for (int k = 0; k < 4; ++k)
+				c[r][k] = _mm256_set1_ps(m[r][k]);
+
+		const __m256 one = _mm256_set1_ps(1.0f);
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 x = _mm256_loadu_ps(&in.x[i]);
+			const __m256 y = _mm256_loadu_ps(&in.y[i]);
+			const __m256 z = _mm256_loadu_ps(&in.z[i]);
+			const __m256 w = has_in_w ? _mm256_loadu_ps(&in.w[i]) : one;
+
+			__m256 result[4];
+			for (int r = 0; r < 4; ++r)
+			{
+				result[r] = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(c[r][0], x), _mm256_mul_ps(c[r][1], y)),
+					_mm256_add_ps(_mm256_mul_ps(c[r][2], z), _mm256_mul_ps(c[r][3], w)));
+			}
+
+			_mm256_storeu_ps(&out.x[i], result[0]);
+			_mm256_storeu_ps(&out.y[i], result[1]);
+			_mm256_storeu_ps(&out.z[i], result[2]);
+			if (has_out_w)
+				_mm256_storeu_ps(&out.w[i], result[3]);
+		}
+#elif defined(SIMD_SSE2)
+		__m128 c[4][4];
+		for (int r = 0; r < 4; ++r)
+			for (int k = 0; k < 4; ++k)
+				c[r][k] = _mm_set1_ps(m[r][k]);
+
+		const __m128 one = _mm_set1_ps(1.0f);
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 x = _mm_loadu_ps(&in.x[i]);
+			const __m128 y = _mm_loadu_ps(&in.y[i]);
+			const __m128 z = _mm_loadu_ps(&in.z[i]);
+			const __m128 w = has_in_w ? _mm_loadu_ps(&in.w[i]) : one;
+
+			__m128 result[4];
+			for (int r = 0; r < 4; ++r)
+			{
+				result[r] = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(c[r][0], x), _mm_mul_ps(c[r][1], y)),
+					_mm_add_ps(_mm_mul_ps(c[r][2], z), _mm_mul_ps(c[r][3], w)));
+			}
+
+			_mm_storeu_ps(&out.x[i], result[0]);
+			_mm_storeu_ps(&out.y[i], result[1]);
+			_mm_storeu_ps(&out.z[i], result[2]);
+			if (has_out_w)
+				_mm_storeu_ps(&out.w[i], result[3]);
+		}
+#endif
+
+		// scalar tail (or everything without simd support)
+		for (; i < count; ++i)
+		{
+			const float x = in.x[i];
+			const float y = in.y[i];
+			const float z = in.z[i];
+			const float w = has_in_w ? in.w[i] : 1.0f;
+
+			out.x[i] = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3] * w;
+			out.y[i] = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3] * w;
+			out.z[i] = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3] * w;
+			if (has_out_w)
+				out.w[i] = m[3][0] * x + m[3][1] * y + m[3][2] * z + m[3][3] * w;
+		}
 	}
-}
 
-mat4f operator * (const mat4f& lhs, const mat4f& rhs)
-{
-	return mat::multiply(lhs, rhs);
-}
+	void transform(const mat4f& m, std::span<const SimpleVertex> in, std::span<vec4f> out)
+	{
+		if (in.size() != out.size())
+		{
+			throw std::invalid_argument("mat::transform: input and output differ in size");
+		}
+
+#if defined(SIMD_SSE2)
+		// columns of the matrix, the result is the sum of the columns scaled by the position components
+		__m128 c0 = _mm_loadu_ps(m[0].data());
+		__m128 c1 = _mm_loadu_ps(m[1].data());
+		__m128 c2 = _mm_loadu_ps(m[2].data());
+		__m128 c3 = _mm_loadu_ps(m[3].data());
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
 
-vec4f operator * (const mat4f& m, const vec4f& v)
-{
-	return mat::multiply(m, v);
+		for (std::size_t i = 0; i < in.size(); ++i)
+		{
+			const auto& pos = in[i].pos;
+			const __m128 result = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(pos.x)), _mm_mul_ps(c1, _mm_set1_ps(pos.y))),
+				_mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(pos.z)), c3));
+			_mm_store_ps(out[i].data, result);
+		}
+#else
+		for (std::size_t i = 0; i < in.size(); ++i)
+		{
+			out[i] = multiply(m, vec4f(in[i].pos.x, in[i].pos.y, in[i].pos.z, 1.0f));
+		}
+#endif
+	}
+
+	void transform(const mat4f& m, std::span<const SimpleVertex> in, std::span<SimpleVertex> out)
+	{
+		if (in.size() != out.size())
+		{
+			throw std::invalid_argument("mat::transform: input and output differ in size");
+		}
+
+#if defined(SIMD_SSE2)
+		__m128 c0 = _mm_loadu_ps(m[0].data());
+		__m128 c1 = _mm_loadu_ps(m[1].data());
+		__m128 c2 = _mm_loadu_ps(m[2].data());
+		__m128 c3 = _mm_loadu_ps(m[3].data());
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+		for (std::size_t i = 0; i < in.size(); ++i)
+		{
+			const auto pos = in[i].pos;
+			vec4f result(_mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(pos.x)), _mm_mul_ps(c1, _mm_set1_ps(pos.y))),
+				_mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(pos.z)), c3)));
+			out[i].pos = vec3f(result.x, result.y, result.z);
+			out[i].color = in[i].color;
+		}
+#else
+		for (std::size_t i = 0; i < in.size(); ++i)
+		{
+			const auto pos = in[i].pos;
+			out[i].pos = vec3f(
+				m[0][0] * pos.x + m[0][1] * pos.y + m[0][2] * pos.z + m[0][3],
+				m[1][0] * pos.x + m[1][1] * pos.y + m[1][2] * pos.z + m[1][3],
+				m[2][0] * pos.x + m[2][1] * pos.y + m[2][2] * pos.z + m[2][3]);
+			out[i].color = in[i].color;
+		}
+#endif
+	}
 }
\ No newline at end of file
@@ -4,26 +4,154 @@
 #pragma once
 
 #include <array>
+#include <span>
+#include <type_traits>
 #include "vec.hpp"
+#include "quat.hpp"
+#include "Vertex.hpp"
 
 using mat4f = std::array<std::array<float, 4>, 4>;
+// the simd kernels rely on the rows being tightly packed
+static_assert(sizeof(mat4f) == sizeof(float) * 16, "mat4f must be 16 tightly packed floats");
 
 namespace mat {
-	mat4f zeroed();
-	mat4f identity();
-	mat4f multiply(const mat4f& a, const mat4f& b);
-	vec4f multiply(const mat4f& mat, const vec4f& vec);
+	namespace detail {
+		// simd kernels, used by multiply / transpose outside of constant evaluation
+		mat4f multiply_kernel(const mat4f& lhs, const mat4f& rhs);
+		vec4f multiply_kernel(const mat4f& mat, const vec4f& vec);
+		mat4f transpose_kernel(const mat4f& m);
+	}
+
+	constexpr mat4f zeroed() {
+		mat4f m{};
+		m[0][0] = 0; m[0][1] = 0; m[0][2] = 0; m[0][3] = 0;
+		m[1][0] = 0; m[1][1] = 0; m[1][2] = 0; m[1][3] = 0;
+		m[2][0] = 0; m[2][1] = 0; m[2][2] = 0; m[2][3] = 0;
+		m[3][0] = 0; m[3][1] = 0; m[3][2] = 0; m[3][3] = 0;
+		return m;
+	}
+
+	constexpr mat4f identity() {
+		mat4f m{};
+		m[0][0] = 1; m[0][1] = 0; m[0][2] = 0; m[0][3] = 0;
+		m[1][0] = 0; m[1][1] = 1; m[1][2] = 0; m[1][3] = 0;
+		m[2][0] = 0; m[2][1] = 0; m[2][2] = 1; m[2][3] = 0;
+		m[3][0] = 0; m[3][1] = 0; m[3][2] = 0; m[3][3] = 1;
+		return m;
+	}
+
+	constexpr mat4f multiply(const mat4f& lhs, const mat4f& rhs) {
+		if (!std::is_constant_evaluated())
+			return detail::multiply_kernel(lhs, rhs);
+
+		mat4f resultMatrix{};
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				for (int k = 0; k < 4; k++)
+					resultMatrix[i][j] += lhs[i][k] * rhs[k][j];
+		return resultMatrix;
+	}
+
+	constexpr vec4f multiply(const mat4f& mat, const vec4f& vec) {
+		if (!std::is_constant_evaluated())
+			return detail::multiply_kernel(mat, vec);
+
+		return vec4f(
+			mat[0][0] * vec.x + mat[0][1] * vec.y + mat[0][2] * vec.z + mat[0][3] * vec.w,
+			mat[1][0] * vec.x + mat[1][1] * vec.y + mat[1][2] * vec.z + mat[1][3] * vec.w,
+			mat[2][0] * vec.x + mat[2][1] * vec.y + mat[2][2] * vec.z + mat[2][3] * vec.w,
+			mat[3][0] * vec.x + mat[3][1] * vec.y + mat[3][2] * vec.z + mat[3][3] * vec.w);
+	}
+
+	constexpr mat4f ortho(float width, float height, float nearPlane, float farPlane) {
+		mat4f result = identity();
+
+		result[0][0] = 2.0f / width;
+		result[1][1] = 2.0f / height;
+		result[2][2] = 1.0f / (farPlane - nearPlane);
+		result[2][3] = nearPlane / (nearPlane - farPlane);
+		return result;
+	}
+
+	constexpr mat4f ortho(const vec2f& dimension, const vec2f& near_far_planes) {
+		return ortho(dimension.x, dimension.y, near_far_planes.x, near_far_planes.y);
+	}
+
+	constexpr mat4f translate(const vec3f& v)
+	{
+		mat4f m = identity();
+		m[0][3] = v.x;
+		m[1][3] = v.y;
+		m[2][3] = v.z;
+		return m;
+	}
+
+	constexpr mat4f transpose(const mat4f& m)
+	{
+		if (!std::is_constant_evaluated())
+			return detail::transpose_kernel(m);
+
+		mat4f result{};
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				result[i][j] = m[j][i];
+		return result;
+	}
+
+	// General inverse, a singular matrix results in non finite values.
+	mat4f inverse(const mat4f& m);
+	// Inverse of an affine transform (last row is 0 0 0 1), e.g. a view or world matrix. Much cheaper than inverse.
+	mat4f affine_inverse(const mat4f& m);
 
-	mat4f ortho(float width, float height, float nearPlane, float farPlane);
-	mat4f ortho(const vec2f& dimension, const vec2f& near_far_planes);
 	mat4f rotate_z(float angle_in_rad);
+	// rotation matrix of a unit quaternion
+	constexpr mat4f rotate(const quatf& q)
+	{
+		const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+		mat4f m = identity();
+		m[0][0] = 1.0f - 2.0f * (yy + zz); m[0][1] = 2.0f * (xy - wz); m[0][2] = 2.0f * (xz + wy);
+		m[1][0] = 2.0f * (xy + wz); m[1][1] = 1.0f - 2.0f * (xx + zz); m[1][2] = 2.0f * (yz - wx);
+		m[2][0] = 2.0f * (xz - wy); m[2][1] = 2.0f * (yz + wx); m[2][2] = 1.0f - 2.0f * (xx + yy);
+		return m;
+	}
 	mat4f proj(float fov, float aspect, float near_plane, float far_plane);
 	mat4f look_at(vec3f eye, vec3f at, vec3f up);
 	mat4f look_to(vec3f eye, vec3f to, vec3f up);
-	mat4f translate(const vec3f& v);
+
+	// Structure of arrays view over a set of points, all non empty spans must have the same size.
+	// An empty w span on input means w = 1, an empty w span on output skips writing w.
+	struct soa_points
+	{
+		std::span<const float> x, y, z, w;
+	};
+
+	struct soa_points_out
+	{
+		std::span<float> x, y, z, w;
+	};
+
+	// Batched transforms, processing 8 (AVX2) or 4 (SSE2) points per iteration. in and out may alias.
+	void transform(const mat4f& m, const soa_points& in, const soa_points_out& out);
+	// The vertex overloads transform one vertex per iteration with the matrix columns in sse registers.
+	// Gathering four interleaved positions into lanes measured slower (memory bound, plus the transpose
+	// back), vertices that need the 8 / 4 wide path should be kept as soa_points.
+	// Transforms the vertex positions (w = 1) into homogeneous coordinates, e.g. into clip space.
+	void transform(const mat4f& m, std::span<const SimpleVertex> in, std::span<vec4f> out);
+	// Transforms the vertex positions by an affine matrix, the colors are copied.
+	void transform(const mat4f& m, std::span<const SimpleVertex> in, std::span<SimpleVertex> out);
 }
 
-mat4f operator * (const mat4f& lhs, const mat4f& rhs);
-vec4f operator * (const mat4f& m, const vec4f& v);
+constexpr mat4f operator * (const mat4f& lhs, const mat4f& rhs)
+{
+	return mat::multiply(lhs, rhs);
+}
+
+constexpr vec4f operator * (const mat4f& m, const vec4f& v)
+{
+	return mat::multiply(m, v);
+}
 
 #endif
\ No newline at end of file
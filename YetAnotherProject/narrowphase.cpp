@@ -0,0 +1,426 @@
+#include "narrowphase.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "simd.hpp"
+
+using namespace simd;
+
+namespace collision {
+	namespace {
+		// one vector per lane, the batched counterpart of vec3f
+		struct float4x3
+		{
+			float4 x, y, z;
+		};
+
+		float4x3 operator + (const float4x3& a, const float4x3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+		float4x3 operator - (const float4x3& a, const float4x3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		float4x3 operator - (const float4x3& a) { return { -a.x, -a.y, -a.z }; }
+		float4x3 operator * (const float4x3& a, float4 f) { return { a.x * f, a.y * f, a.z * f }; }
+
+		float4 dot(const float4x3& a, const float4x3& b)
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		float4x3 cross(const float4x3& a, const float4x3& b)
+		{
+			return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+		}
+
+		float4x3 select(float4 mask, const float4x3& a, const float4x3& b)
+		{
+			return { simd::select(mask, a.x, b.x), simd::select(mask, a.y, b.y), simd::select(mask, a.z, b.z) };
+		}
+
+		float4 clamp(float4 v, float4 low, float4 high)
+		{
+			return simd::min(simd::max(v, low), high);
+		}
+
+		// -1, 0 or 1, values within epsilon of 0 count as 0
+		float4 sign(float4 v, float4 epsilon)
+		{
+			return simd::select(v > epsilon, set1(1.0f), simd::select(v < -epsilon, set1(-1.0f), set1(0.0f)));
+		}
+
+		float4x3 gather(const vec3f (&v)[4])
+		{
+			return {
+				set(v[0].x, v[1].x, v[2].x, v[3].x),
+				set(v[0].y, v[1].y, v[2].y, v[3].y),
+				set(v[0].z, v[1].z, v[2].z, v[3].z) };
+		}
+
+		float4 gather(const float (&f)[4])
+		{
+			return load(f);
+		}
+
+		// hit mask and contact of four pairs
+		struct result
+		{
+			float4 hit;
+			float4 depth;
+			float4x3 normal;
+			float4x3 point;
+		};
+
+		struct obb_lanes
+		{
+			float4x3 center;
+			float4 extent[3];
+			float4x3 axes[3];
+		};
+
+		template <typename Shape>
+		const Shape& get_shape(std::span<const Shape> shapes, uint32_t index, const char* name)
+		{
+			if (index >= shapes.size())
+			{
+				throw std::invalid_argument(std::string(name) + ": pair index out of range");
+			}
+			return shapes[index];
+		}
+
+		obb_lanes gather_obbs(const obb* (&boxes)[4])
+		{
+			obb_lanes lanes;
+			lanes.center = gather({ boxes[0]->center, boxes[1]->center, boxes[2]->center, boxes[3]->center });
+			for (int i = 0; i < 3; ++i)
+			{
+				lanes.extent[i] = set(boxes[0]->extent[i], boxes[1]->extent[i], boxes[2]->extent[i], boxes[3]->extent[i]);
+				lanes.axes[i] = gather({ boxes[0]->axes[i], boxes[1]->axes[i], boxes[2]->axes[i], boxes[3]->axes[i] });
+			}
+			return lanes;
+		}
+
+		// Runs kernel(first, second) over the pairs four at a time, with the shapes of every lane. The last
+		// batch repeats its last pair in the unused lanes, which are masked off again.
+		template <typename FirstShape, typename SecondShape, typename Kernel>
+		std::size_t collide(std::span<const FirstShape> first, std::span<const SecondShape> second,
+			std::span<const pair> pairs, std::span<contact> contacts, const char* name, Kernel kernel)
+		{
+			if (contacts.size() < pairs.size())
+			{
+				throw std::invalid_argument(std::string(name) + ": contacts is too small");
+			}
+
+			std::size_t contact_count = 0;
+			for (std::size_t i = 0; i < pairs.size(); i += 4)
+			{
+				const std::size_t lanes = std::min<std::size_t>(pairs.size() - i, 4);
+
+				const FirstShape* a[4];
+				const SecondShape* b[4];
+				for (std::size_t lane = 0; lane < 4; ++lane)
+				{
+					const pair& p = pairs[i + std::min(lane, lanes - 1)];
+					a[lane] = &get_shape(first, p.a, name);
+					b[lane] = &get_shape(second, p.b, name);
+				}
+
+				const result r = kernel(a, b);
+				const int mask = mask_bits(r.hit) & ((1 << lanes) - 1);
+				if (!mask)
+					continue;
+
+				float depth[4], normal[3][4], point[3][4];
+				store(depth, r.depth);
+				store(normal[0], r.normal.x);
+				store(normal[1], r.normal.y);
+				store(normal[2], r.normal.z);
+				store(point[0], r.point.x);
+				store(point[1], r.point.y);
+				store(point[2], r.point.z);
+
+				for (std::size_t lane = 0; lane < lanes; ++lane)
+				{
+					if (!((mask >> lane) & 1))
+						continue;
+
+					contact& c = contacts[contact_count++];
+					c.pair = static_cast<uint32_t>(i + lane);
+					c.depth = depth[lane];
+					c.normal = vec3f(normal[0][lane], normal[1][lane], normal[2][lane]);
+					c.point = vec3f(point[0][lane], point[1][lane], point[2][lane]);
+				}
+			}
+
+			return contact_count;
+		}
+
+		// overlap of both boxes projected onto axis (not necessarily unit length), negative if it separates them
+		float4 axis_overlap(const obb_lanes& a, const obb_lanes& b, const float4x3& offset, const float4x3& axis, float4 inv_length)
+		{
+			float4 radius = set1(0.0f);
+			for (int i = 0; i < 3; ++i)
+			{
+				radius = radius + a.extent[i] * simd::abs(dot(a.axes[i], axis));
+				radius = radius + b.extent[i] * simd::abs(dot(b.axes[i], axis));
+			}
+			return (radius - simd::abs(dot(offset, axis))) * inv_length;
+		}
+
+		// deepest point of the box along direction, the middle of a face or edge perpendicular to it
+		float4x3 support(const obb_lanes& box, const float4x3& direction)
+		{
+			float4x3 p = box.center;
+			for (int i = 0; i < 3; ++i)
+				p = p + box.axes[i] * (sign(dot(box.axes[i], direction), set1(1e-3f)) * box.extent[i]);
+			return p;
+		}
+
+		// Slab test of the segment start + segment * [0, 1] against the box [-extent, extent]. Unlike a distance
+		// threshold this doesn't depend on the length of the segment.
+		float4 segment_intersects_box(const float4x3& start, const float4x3& segment, const float4 (&extent)[3])
+		{
+			const float4 zero = set1(0.0f);
+			const float4 one = set1(1.0f);
+			const float4 far = set1(std::numeric_limits<float>::max());
+			const float4 starts[3] = { start.x, start.y, start.z };
+			const float4 directions[3] = { segment.x, segment.y, segment.z };
+
+			float4 enter = zero;
+			float4 exit = one;
+			for (int i = 0; i < 3; ++i)
+			{
+				// parallel to the slab: either always or never within it
+				const float4 parallel = simd::abs(directions[i]) <= set1(1e-12f);
+				const float4 within = simd::abs(starts[i]) <= extent[i];
+				const float4 inv_direction = one / simd::select(parallel, one, directions[i]);
+				const float4 t0 = (-extent[i] - starts[i]) * inv_direction;
+				const float4 t1 = (extent[i] - starts[i]) * inv_direction;
+
+				enter = simd::max(enter, simd::select(parallel, simd::select(within, zero, far), simd::min(t0, t1)));
+				exit = simd::min(exit, simd::select(parallel, simd::select(within, one, -far), simd::max(t0, t1)));
+			}
+			return enter <= exit;
+		}
+	}
+
+	obb make_obb(const vec3f& center, const vec3f& extent, const quatf& orientation)
+	{
+		obb box;
+		box.center = center;
+		box.extent = extent;
+		box.axes[0] = quat::rotate(orientation, vec3f(1.0f, 0.0f, 0.0f));
+		box.axes[1] = quat::rotate(orientation, vec3f(0.0f, 1.0f, 0.0f));
+		box.axes[2] = quat::rotate(orientation, vec3f(0.0f, 0.0f, 1.0f));
+		return box;
+	}
+
+	std::size_t collide_aabbs(std::span<const spatial::aabb> boxes, std::span<const pair> pairs, std::span<contact> contacts)
+	{
+		return collide(boxes, boxes, pairs, contacts, "collision::collide_aabbs", [](const spatial::aabb* (&a)[4], const spatial::aabb* (&b)[4])
+		{
+			const float4x3 min_a = gather({ a[0]->min, a[1]->min, a[2]->min, a[3]->min });
+			const float4x3 max_a = gather({ a[0]->max, a[1]->max, a[2]->max, a[3]->max });
+			const float4x3 min_b = gather({ b[0]->min, b[1]->min, b[2]->min, b[3]->min });
+			const float4x3 max_b = gather({ b[0]->max, b[1]->max, b[2]->max, b[3]->max });
+
+			// how far b has to move along each axis to get out, towards the side its center is on
+			const float4x3 push_up = max_a - min_b;
+			const float4x3 push_down = max_b - min_a;
+			const float4x3 overlap = { simd::min(push_up.x, push_down.x), simd::min(push_up.y, push_down.y), simd::min(push_up.z, push_down.z) };
+			const float4x3 offset = (min_b + max_b) - (min_a + max_a);
+			// the region both boxes cover
+			const float4x3 low = { simd::max(min_a.x, min_b.x), simd::max(min_a.y, min_b.y), simd::max(min_a.z, min_b.z) };
+			const float4x3 high = { simd::min(max_a.x, max_b.x), simd::min(max_a.y, max_b.y), simd::min(max_a.z, max_b.z) };
+
+			const float4 zero = set1(0.0f);
+			const float4 one = set1(1.0f);
+			const float4 use_x = (overlap.x <= overlap.y) & (overlap.x <= overlap.z);
+			const float4 use_y = (overlap.y < overlap.x) & (overlap.y <= overlap.z);
+			const float4 use_z = (overlap.z < overlap.x) & (overlap.z < overlap.y);
+
+			result r;
+			r.hit = (overlap.x >= zero) & (overlap.y >= zero) & (overlap.z >= zero);
+			r.depth = simd::min(overlap.x, simd::min(overlap.y, overlap.z));
+			r.normal = {
+				simd::select(use_x, simd::select(offset.x < zero, -one, one), zero),
+				simd::select(use_y, simd::select(offset.y < zero, -one, one), zero),
+				simd::select(use_z, simd::select(offset.z < zero, -one, one), zero) };
+			r.point = (low + high) * set1(0.5f);
+			return r;
+		});
+	}
+
+	std::size_t collide_spheres(std::span<const sphere> spheres, std::span<const pair> pairs, std::span<contact> contacts)
+	{
+		return collide(spheres, spheres, pairs, contacts, "collision::collide_spheres", [](const sphere* (&a)[4], const sphere* (&b)[4])
+		{
+			const float4x3 center_a = gather({ a[0]->center, a[1]->center, a[2]->center, a[3]->center });
+			const float4x3 center_b = gather({ b[0]->center, b[1]->center, b[2]->center, b[3]->center });
+			const float4 radius_a = gather({ a[0]->radius, a[1]->radius, a[2]->radius, a[3]->radius });
+			const float4 radius_b = gather({ b[0]->radius, b[1]->radius, b[2]->radius, b[3]->radius });
+
+			const float4x3 offset = center_b - center_a;
+			const float4 distance = simd::sqrt(dot(offset, offset));
+			const float4 radius = radius_a + radius_b;
+			// concentric spheres have no preferred direction, any is fine
+			const float4 degenerate = distance <= set1(1e-6f);
+
+			result r;
+			r.hit = distance <= radius;
+			r.depth = radius - distance;
+			r.normal = select(degenerate, float4x3{ set1(0.0f), set1(1.0f), set1(0.0f) }, offset * (set1(1.0f) / simd::max(distance, set1(1e-6f))));
+			r.point = center_a + r.normal * (radius_a - r.depth * set1(0.5f));
+			return r;
+		});
+	}
+
+	std::size_t collide_obbs(std::span<const obb> boxes, std::span<const pair> pairs, std::span<contact> contacts)
+	{
+		return collide(boxes, boxes, pairs, contacts, "collision::collide_obbs", [](const obb* (&a)[4], const obb* (&b)[4])
+		{
+			const obb_lanes box_a = gather_obbs(a);
+			const obb_lanes box_b = gather_obbs(b);
+			const float4x3 offset = box_b.center - box_a.center;
+
+			enum feature { face_a, face_b, edge };
+			const float4 one = set1(1.0f);
+			float4 best = set1(std::numeric_limits<float>::max());
+			float4x3 best_axis = box_a.axes[0];
+			float4 best_feature = set1(face_a);
+
+			for (int i = 0; i < 3; ++i)
+			{
+				const float4 overlap_a = axis_overlap(box_a, box_b, offset, box_a.axes[i], one);
+				const float4 better_a = overlap_a < best;
+				best = simd::select(better_a, overlap_a, best);
+				best_axis = select(better_a, box_a.axes[i], best_axis);
+				best_feature = simd::select(better_a, set1(face_a), best_feature);
+			}
+
+			for (int i = 0; i < 3; ++i)
+			{
+				const float4 overlap_b = axis_overlap(box_a, box_b, offset, box_b.axes[i], one);
+				const float4 better_b = overlap_b < best;
+				best = simd::select(better_b, overlap_b, best);
+				best_axis = select(better_b, box_b.axes[i], best_axis);
+				best_feature = simd::select(better_b, set1(face_b), best_feature);
+			}
+
+			for (int i = 0; i < 3; ++i)
+			{
+				for (int j = 0; j < 3; ++j)
+				{
+					// edges of (nearly) parallel axes are covered by the face axes
+					const float4x3 axis = cross(box_a.axes[i], box_b.axes[j]);
+					const float4 length = simd::sqrt(dot(axis, axis));
+					const float4 valid = length > set1(1e-4f);
+					const float4 overlap = axis_overlap(box_a, box_b, offset, axis, one / simd::max(length, set1(1e-4f)));
+
+					// prefer faces when they are about as deep, their contact points are more stable
+					const float4 better = valid & (overlap < best * set1(0.95f));
+					best = simd::select(better, overlap, best);
+					best_axis = select(better, axis * (one / simd::max(length, set1(1e-4f))), best_axis);
+					best_feature = simd::select(better, set1(edge), best_feature);
+				}
+			}
+
+			// point the normal from a to b
+			const float4x3 normal = select(dot(best_axis, offset) < set1(0.0f), -best_axis, best_axis);
+			const float4 half_depth = best * set1(0.5f);
+			const float4x3 point_on_a = support(box_a, normal) - normal * half_depth;
+			const float4x3 point_on_b = support(box_b, -normal) + normal * half_depth;
+
+			result r;
+			r.hit = best >= set1(0.0f);
+			r.depth = best;
+			r.normal = normal;
+			// deepest point of the incident box, the reference face is the one the normal belongs to
+			r.point = select(simd::abs(best_feature - set1(face_b)) < set1(0.5f), point_on_a, point_on_b);
+			return r;
+		});
+	}
+
+	std::size_t collide_capsule_obbs(std::span<const capsule> capsules, std::span<const obb> boxes, std::span<const pair> pairs, std::span<contact> contacts)
+	{
+		return collide(capsules, boxes, pairs, contacts, "collision::collide_capsule_obbs", [](const capsule* (&a)[4], const obb* (&b)[4])
+		{
+			const obb_lanes box = gather_obbs(b);
+			const float4 radius = gather({ a[0]->radius, a[1]->radius, a[2]->radius, a[3]->radius });
+			const float4x3 world_start = gather({ a[0]->a, a[1]->a, a[2]->a, a[3]->a }) - box.center;
+			const float4x3 world_end = gather({ a[0]->b, a[1]->b, a[2]->b, a[3]->b }) - box.center;
+
+			// segment in the box space, where the box is [-extent, extent]
+			const float4x3 start = { dot(world_start, box.axes[0]), dot(world_start, box.axes[1]), dot(world_start, box.axes[2]) };
+			const float4x3 end = { dot(world_end, box.axes[0]), dot(world_end, box.axes[1]), dot(world_end, box.axes[2]) };
+			const float4x3 segment = end - start;
+
+			const float4 zero = set1(0.0f);
+			const float4 one = set1(1.0f);
+			const float4 half = set1(0.5f);
+			auto clamp_to_box = [&](const float4x3& p) -> float4x3
+			{
+				return { clamp(p.x, -box.extent[0], box.extent[0]), clamp(p.y, -box.extent[1], box.extent[1]), clamp(p.z, -box.extent[2], box.extent[2]) };
+			};
+
+			// The squared distance to the box is convex along the segment, so the closest point is found by
+			// bisecting on the sign of its derivative.
+			float4 t_low = zero;
+			float4 t_high = one;
+			for (int iteration = 0; iteration < 20; ++iteration)
+			{
+				const float4 t = (t_low + t_high) * half;
+				const float4x3 p = start + segment * t;
+				const float4 rising = dot(p - clamp_to_box(p), segment) > zero;
+				t_high = simd::select(rising, t, t_high);
+				t_low = simd::select(rising, t_low, t);
+			}
+
+			const float4x3 on_segment = start + segment * ((t_low + t_high) * half);
+			const float4x3 on_box = clamp_to_box(on_segment);
+			const float4x3 offset = on_box - on_segment;
+			const float4 distance = simd::sqrt(dot(offset, offset));
+			const float4 inside = segment_intersects_box(start, segment, box.extent);
+
+			// segment outside: along the closest points
+			const float4x3 outside_normal = offset * (one / simd::max(distance, set1(1e-6f)));
+			const float4 outside_depth = radius - distance;
+			// halfway between the capsule surface (on_segment + normal * radius) and on_box
+			const float4x3 outside_point = (on_segment + outside_normal * radius + on_box) * half;
+
+			// Segment inside: separating axis test between the segment and the box, the capsule only adds its
+			// radius in every direction. The candidates are the box faces and segment x box edges.
+			const float4x3 middle = (start + end) * half;
+			const float4x3 half_segment = segment * half;
+			const float4x3 units[3] = { { one, zero, zero }, { zero, one, zero }, { zero, zero, one } };
+			float4 best = set1(std::numeric_limits<float>::max());
+			float4x3 best_axis = units[0];
+			for (int i = 0; i < 6; ++i)
+			{
+				const float4x3 axis = i < 3 ? units[i] : cross(half_segment, units[i - 3]);
+				const float4 length = simd::sqrt(dot(axis, axis));
+				const float4 extent = box.extent[0] * simd::abs(axis.x) + box.extent[1] * simd::abs(axis.y) + box.extent[2] * simd::abs(axis.z);
+				const float4 overlap = (extent + simd::abs(dot(half_segment, axis)) - simd::abs(dot(middle, axis))) / simd::max(length, set1(1e-6f));
+
+				const float4 better = (length > set1(1e-6f)) & (overlap < best);
+				best = simd::select(better, overlap, best);
+				best_axis = select(better, axis * (one / simd::max(length, set1(1e-6f))), best_axis);
+			}
+
+			// the box center is at the origin, point the normal towards it
+			const float4x3 inside_normal = select(dot(best_axis, middle) > zero, -best_axis, best_axis);
+			const float4 inside_depth = best + radius;
+			const float4x3 deepest = middle + half_segment * sign(dot(half_segment, inside_normal), set1(1e-6f)) + inside_normal * radius;
+			const float4x3 inside_point = deepest - inside_normal * (inside_depth * half);
+
+			const float4x3 normal = select(inside, inside_normal, outside_normal);
+			const float4 depth = simd::select(inside, inside_depth, outside_depth);
+			const float4x3 local_point = select(inside, inside_point, outside_point);
+
+			result r;
+			r.hit = inside | (distance <= radius);
+			r.depth = depth;
+			r.normal = box.axes[0] * normal.x + box.axes[1] * normal.y + box.axes[2] * normal.z;
+			r.point = box.center + box.axes[0] * local_point.x + box.axes[1] * local_point.y + box.axes[2] * local_point.z;
+			return r;
+		});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef NARROWPHASE_INCLUDED
+#define NARROWPHASE_INCLUDED
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include "vec.hpp"
+#include "quat.hpp"
+#include "bvh.hpp"
+#include "hash_grid.hpp"
+
+namespace collision {
+	using pair = spatial::hash_grid::pair;
+
+	struct sphere
+	{
+		vec3f center;
+		float radius;
+	};
+
+	// oriented box, axes are orthonormal
+	struct obb
+	{
+		vec3f center;
+		vec3f extent;
+		vec3f axes[3];
+	};
+
+	// segment from a to b, swept by radius
+	struct capsule
+	{
+		vec3f a;
+		vec3f b;
+		float radius;
+	};
+
+	struct contact
+	{
+		// index into the pair list
+		uint32_t pair;
+		// penetration along normal, moving the second shape by normal * depth separates the shapes
+		float depth;
+		// unit length, from the first shape of the pair to the second
+		vec3f normal;
+		// halfway between the deepest points of both shapes
+		vec3f point;
+	};
+
+	obb make_obb(const vec3f& center, const vec3f& extent, const quatf& orientation);
+
+	// Narrowphase over the candidate pairs of a broadphase (e.g. hash_grid::find_pairs), four pairs per
+	// iteration. The pair members index the shape spans. Writes a contact for every touching pair,
+	// compacted and in pair order, and returns how many there are. contacts must be at least as large as
+	// pairs, throws std::invalid_argument if it isn't or a pair indexes outside of the shapes.
+	std::size_t collide_aabbs(std::span<const spatial::aabb> boxes, std::span<const pair> pairs, std::span<contact> contacts);
+	std::size_t collide_spheres(std::span<const sphere> spheres, std::span<const pair> pairs, std::span<contact> contacts);
+	// separating axis test over the 15 axes, the contact point is a single (approximate) point of the touching features
+	std::size_t collide_obbs(std::span<const obb> boxes, std::span<const pair> pairs, std::span<contact> contacts);
+	// pair.a indexes capsules and pair.b boxes, the normal points from the capsule to the box
+	std::size_t collide_capsule_obbs(std::span<const capsule> capsules, std::span<const obb> boxes, std::span<const pair> pairs, std::span<contact> contacts);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include "occlusion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "simd.hpp"
+
+using namespace simd;
+
+namespace cull {
+	namespace {
+		float horizontal_max(float4 a)
+		{
+			float v[4];
+			store(v, a);
+			return std::max(std::max(v[0], v[1]), std::max(v[2], v[3]));
+		}
+	}
+
+	occlusion_buffer::occlusion_buffer(uint32_t width, uint32_t height)
+		: _width(width), _height(height), _tiles_x(width / tile_size), _tiles_y(height / tile_size),
+		_view_proj(mat::identity()), _finalized(false),
+		_depth(static_cast<std::size_t>(width) * height, 1.0f),
+		_tile_depth(static_cast<std::size_t>(_tiles_x) * _tiles_y, 1.0f)
+	{
+		if (width == 0 || height == 0 || width % tile_size != 0 || height % tile_size != 0)
+		{
+			throw std::invalid_argument("cull::occlusion_buffer: size must be a non zero multiple of the tile size");
+		}
+	}
+
+	void occlusion_buffer::begin(const mat4f& view_proj)
+	{
+		_view_proj = view_proj;
+		_finalized = false;
+		std::fill(_depth.begin(), _depth.end(), 1.0f);
+	}
+
+	void occlusion_buffer::rasterize_occluder(const mat4f& world, std::span<const vec3f> triangles)
+	{
+		if (_finalized)
+		{
+			throw std::logic_error("cull::occlusion_buffer: rasterize_occluder after finalize");
+		}
+
+		const mat4f world_view_proj = _view_proj * world;
+		for (std::size_t i = 0; i + 3 <= triangles.size(); i += 3)
+		{
+			const vec4f v0 = world_view_proj * vec4f(triangles[i + 0].x, triangles[i + 0].y, triangles[i + 0].z, 1.0f);
+			const vec4f v1 = world_view_proj * vec4f(triangles[i + 1].x, triangles[i + 1].y, triangles[i + 1].z, 1.0f);
+			const vec4f v2 = world_view_proj * vec4f(triangles[i + 2].x, triangles[i + 2].y, triangles[i + 2].z, 1.0f);
+			rasterize_triangle(v0, v1, v2);
+		}
+	}
+
+	void occlusion_buffer::finalize()
+	{
+		for (uint32_t ty = 0; ty < _tiles_y; ++ty)
+		{
+			for (uint32_t tx = 0; tx < _tiles_x; ++tx)
+			{
+				float4 farthest = set1(0.0f);
+				for (uint32_t y = ty * tile_size; y < (ty + 1) * tile_size; ++y)
+				{
+					const float* row = &_depth[static_cast<std::size_t>(y) * _width + tx * tile_size];
+					for (uint32_t x = 0; x < tile_size; x += 4)
+						farthest = max(farthest, load(row + x));
+				}
+				_tile_depth[ty * _tiles_x + tx] = horizontal_max(farthest);
+			}
+		}
+
+		_finalized = true;
+	}
+
+	std::size_t occlusion_buffer::cull_aabbs(const aabb_soa& boxes, std::span<uint32_t> visible, uint32_t first_index) const
+	{
+		const std::size_t count = boxes.center_x.size();
+		if (boxes.center_y.size() != count || boxes.center_z.size() != count ||
+			boxes.extent_x.size() != count || boxes.extent_y.size() != count || boxes.extent_z.size() != count)
+		{
+			throw std::invalid_argument("cull::occlusion_buffer::cull_aabbs: soa spans differ in size");
+		}
+		if (visible.size() < count)
+		{
+			throw std::invalid_argument("cull::occlusion_buffer::cull_aabbs: visible is too small");
+		}
+		if (!_finalized)
+		{
+			throw std::logic_error("cull::occlusion_buffer: finalize has to be called before testing");
+		}
+
+		std::size_t visible_count = 0;
+		std::size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const screen_rects rects = project_boxes(
+				load(&boxes.center_x[i]), load(&boxes.center_y[i]), load(&boxes.center_z[i]),
+				load(&boxes.extent_x[i]), load(&boxes.extent_y[i]), load(&boxes.extent_z[i]));
+
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				if (test_rect(rects, lane))
+					visible[visible_count++] = first_index + static_cast<uint32_t>(i + lane);
+			}
+		}
+
+		for (; i < count; ++i)
+		{
+			const vec3f center(boxes.center_x[i], boxes.center_y[i], boxes.center_z[i]);
+			const vec3f extent(boxes.extent_x[i], boxes.extent_y[i], boxes.extent_z[i]);
+			if (is_visible(center, extent))
+				visible[visible_count++] = first_index + static_cast<uint32_t>(i);
+		}
+
+		return visible_count;
+	}
+
+	bool occlusion_buffer::is_visible(const vec3f& center, const vec3f& extent) const
+	{
+		if (!_finalized)
+		{
+			throw std::logic_error("cull::occlusion_buffer: finalize has to be called before testing");
+		}
+
+		const screen_rects rects = project_boxes(
+			set1(center.x), set1(center.y), set1(center.z), set1(extent.x), set1(extent.y), set1(extent.z));
+		return test_rect(rects, 0);
+	}
+
+	occlusion_buffer::screen_rects occlusion_buffer::project_boxes(float4 center_x, float4 center_y, float4 center_z,
+		float4 extent_x, float4 extent_y, float4 extent_z) const
+	{
+		const auto& m = _view_proj;
+		const float4 half_width = set1(0.5f * static_cast<float>(_width));
+		const float4 half_height = set1(0.5f * static_cast<float>(_height));
+
+		float4 min_x = set1(INFINITY), max_x = set1(-INFINITY);
+		float4 min_y = set1(INFINITY), max_y = set1(-INFINITY);
+		float4 min_z = set1(INFINITY);
+		float4 crosses_near = set1(0.0f) < set1(0.0f);
+
+		// one corner of four boxes per iteration
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const float4 x = (corner & 1) ? center_x + extent_x : center_x - extent_x;
+			const float4 y = (corner & 2) ? center_y + extent_y : center_y - extent_y;
+			const float4 z = (corner & 4) ? center_z + extent_z : center_z - extent_z;
+
+			const float4 clip_x = set1(m[0][0]) * x + set1(m[0][1]) * y + set1(m[0][2]) * z + set1(m[0][3]);
+			const float4 clip_y = set1(m[1][0]) * x + set1(m[1][1]) * y + set1(m[1][2]) * z + set1(m[1][3]);
+			const float4 clip_z = set1(m[2][0]) * x + set1(m[2][1]) * y + set1(m[2][2]) * z + set1(m[2][3]);
+			const float4 clip_w = set1(m[3][0]) * x + set1(m[3][1]) * y + set1(m[3][2]) * z + set1(m[3][3]);
+			crosses_near = crosses_near | (clip_z < set1(0.0f));
+
+			const float4 inv_w = set1(1.0f) / clip_w;
+			const float4 screen_x = (clip_x * inv_w + set1(1.0f)) * half_width;
+			const float4 screen_y = (set1(1.0f) - clip_y * inv_w) * half_height;
+			min_x = min(min_x, screen_x);
+			max_x = max(max_x, screen_x);
+			min_y = min(min_y, screen_y);
+			max_y = max(max_y, screen_y);
+			min_z = min(min_z, clip_z * inv_w);
+		}
+
+		screen_rects rects;
+		store(rects.min_x, min_x);
+		store(rects.min_y, min_y);
+		store(rects.max_x, max_x);
+		store(rects.max_y, max_y);
+		store(rects.nearest, min_z);
+		rects.crosses_near = mask_bits(crosses_near);
+		return rects;
+	}
+
+	bool occlusion_buffer::test_rect(const screen_rects& rects, int lane) const
+	{
+		// the box reaches in front of the near plane, its projection is unbounded
+		if (rects.crosses_near & (1 << lane))
+			return true;
+
+		const float nearest = rects.nearest[lane];
+		const int32_t x0 = static_cast<int32_t>(std::max(0.0f, std::floor(rects.min_x[lane])));
+		const int32_t y0 = static_cast<int32_t>(std::max(0.0f, std::floor(rects.min_y[lane])));
+		const int32_t x1 = static_cast<int32_t>(std::min(static_cast<float>(_width - 1), std::floor(rects.max_x[lane])));
+		const int32_t y1 = static_cast<int32_t>(std::min(static_cast<float>(_height - 1), std::floor(rects.max_y[lane])));
+		if (x0 > x1 || y0 > y1)
+			return false;
+
+		const float4 nearest4 = set1(nearest);
+		const float4 lane_offsets = set(0.0f, 1.0f, 2.0f, 3.0f);
+		for (int32_t ty = y0 / static_cast<int32_t>(tile_size); ty <= y1 / static_cast<int32_t>(tile_size); ++ty)
+		{
+			for (int32_t tx = x0 / static_cast<int32_t>(tile_size); tx <= x1 / static_cast<int32_t>(tile_size); ++tx)
+			{
+				// every pixel of the tile is in front of the box
+				if (_tile_depth[ty * _tiles_x + tx] < nearest)
+					continue;
+
+				const int32_t px0 = std::max(x0, tx * static_cast<int32_t>(tile_size));
+				const int32_t px1 = std::min(x1, (tx + 1) * static_cast<int32_t>(tile_size) - 1);
+				const int32_t py0 = std::max(y0, ty * static_cast<int32_t>(tile_size));
+				const int32_t py1 = std::min(y1, (ty + 1) * static_cast<int32_t>(tile_size) - 1);
+				const float4 first = set1(static_cast<float>(px0));
+				const float4 last = set1(static_cast<float>(px1));
+
+				for (int32_t py = py0; py <= py1; ++py)
+				{
+					const float* row = &_depth[static_cast<std::size_t>(py) * _width];
+					for (int32_t px = px0 & ~3; px <= px1; px += 4)
+					{
+						const float4 pixel_x = set1(static_cast<float>(px)) + lane_offsets;
+						const float4 in_range = (pixel_x >= first) & (pixel_x <= last);
+						if (mask_bits(in_range & (load(row + px) >= nearest4)))
+							return true;
+					}
+				}
+			}
+		}
+
+		return false;
+	}
+
+	uint32_t occlusion_buffer::get_width() const
+	{
+		return _width;
+	}
+
+	uint32_t occlusion_buffer::get_height() const
+	{
+		return _height;
+	}
+
+	std::span<const float> occlusion_buffer::get_depth() const
+	{
+		return _depth;
+	}
+
+	void occlusion_buffer::rasterize_triangle(const vec4f& c0, const vec4f& c1, const vec4f& c2)
+	{
+		const vec4f* clip[3] = { &c0, &c1, &c2 };
+		float x[3], y[3], z[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			// clipping would only add occluder area close to the camera, skipping is conservative
+			if (clip[i]->z < 0.0f || clip[i]->w <= 0.0f)
+				return;
+
+			const float inv_w = 1.0f / clip[i]->w;
+			x[i] = (clip[i]->x * inv_w + 1.0f) * 0.5f * static_cast<float>(_width);
+			y[i] = (1.0f - clip[i]->y * inv_w) * 0.5f * static_cast<float>(_height);
+			z[i] = clip[i]->z * inv_w;
+		}
+
+		float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+		if (area < 0.0f)
+		{
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			std::swap(z[1], z[2]);
+			area = -area;
+		}
+		if (!(area > 0.0f))
+			return;
+
+		const float min_x = std::max(0.0f, std::floor(std::min({ x[0], x[1], x[2] })));
+		const float min_y = std::max(0.0f, std::floor(std::min({ y[0], y[1], y[2] })));
+		const float max_x = std::min(static_cast<float>(_width - 1), std::ceil(std::max({ x[0], x[1], x[2] })));
+		const float max_y = std::min(static_cast<float>(_height - 1), std::ceil(std::max({ y[0], y[1], y[2] })));
+		if (min_x > max_x || min_y > max_y)
+			return;
+
+		// edge functions e = a * x + b * y + c, positive inside. Shifting them by half the pixel footprint
+		// moves the test to the pixel corner farthest outside, so only fully covered pixels pass.
+		float4 edge_a[3], edge_b[3], edge_c[3];
+		float depth_a = 0.0f, depth_b = 0.0f, depth_c = 0.0f;
+		for (int e = 0; e < 3; ++e)
+		{
+			const int i = (e + 1) % 3;
+			const int j = (e + 2) % 3;
+			const float a = y[i] - y[j];
+			const float b = x[j] - x[i];
+			const float c = -(a * x[i] + b * y[i]);
+			edge_a[e] = set1(a);
+			edge_b[e] = set1(b);
+			edge_c[e] = set1(c - 0.5f * (std::fabs(a) + std::fabs(b)));
+
+			depth_a += a * z[e];
+			depth_b += b * z[e];
+			depth_c += c * z[e];
+		}
+
+		// depth plane, moved to the farthest corner of each pixel
+		const float inv_area = 1.0f / area;
+		depth_a *= inv_area;
+		depth_b *= inv_area;
+		depth_c = depth_c * inv_area + 0.5f * (std::fabs(depth_a) + std::fabs(depth_b));
+		const float4 farthest_vertex = set1(std::max({ z[0], z[1], z[2] }));
+
+		const float4 lane_offsets = set(0.5f, 1.5f, 2.5f, 3.5f);
+		const int32_t x0 = static_cast<int32_t>(min_x) & ~3;
+		const int32_t x1 = static_cast<int32_t>(max_x);
+		for (int32_t py = static_cast<int32_t>(min_y); py <= static_cast<int32_t>(max_y); ++py)
+		{
+			const float4 center_y = set1(static_cast<float>(py) + 0.5f);
+			float* row = &_depth[static_cast<std::size_t>(py) * _width];
+			for (int32_t px = x0; px <= x1; px += 4)
+			{
+				const float4 center_x = set1(static_cast<float>(px)) + lane_offsets;
+				const float4 covered =
+					(edge_a[0] * center_x + edge_b[0] * center_y + edge_c[0] >= set1(0.0f)) &
+					(edge_a[1] * center_x + edge_b[1] * center_y + edge_c[1] >= set1(0.0f)) &
+					(edge_a[2] * center_x + edge_b[2] * center_y + edge_c[2] >= set1(0.0f));
+
+				if (mask_bits(covered) == 0)
+					continue;
+
+				const float4 z_pixel = min(set1(depth_a) * center_x + set1(depth_b) * center_y + set1(depth_c), farthest_vertex);
+				const float4 depth = load(row + px);
+				store(row + px, select(covered, min(depth, z_pixel), depth));
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef OCCLUSION_INCLUDED
+#define OCCLUSION_INCLUDED
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "vec.hpp"
+#include "mat4.hpp"
+#include "frustum.hpp"
+#include "simd.hpp"
+
+namespace cull {
+	// Low resolution cpu depth buffer for occlusion culling. A few large occluders are rasterized
+	// conservatively (only fully covered pixels, with the farthest depth inside each pixel) and
+	// bounding boxes are then tested against it, first per tile of 8x8 pixels and per pixel only
+	// where the tile can't decide. A box is only reported hidden when it is behind the occluders
+	// at every pixel it covers, so culling never removes something that is visible.
+	//
+	// Per frame: begin(view_proj), rasterize_occluder(...) for every occluder, finalize() and
+	// then any number of cull_aabbs / is_visible calls, which may run on several threads.
+	class occlusion_buffer
+	{
+	public:
+		static constexpr uint32_t tile_size = 8;
+
+		// width and height must be multiples of tile_size, e.g. 256 x 128
+		occlusion_buffer(uint32_t width, uint32_t height);
+
+		// clears the buffer, view_proj (d3d clip space) is used for the bounding boxes
+		void begin(const mat4f& view_proj);
+		// Rasterizes a triangle list in object space, both windings are drawn.
+		// Triangles crossing the near plane are skipped, which only makes the culling less effective.
+		void rasterize_occluder(const mat4f& world, std::span<const vec3f> triangles);
+		// builds the per tile depths, has to be called after the last occluder
+		void finalize();
+
+		// boxes are given in world space, writes the indices (offset by first_index) of the boxes that
+		// are not occluded compacted to visible and returns how many there are. Boxes completely
+		// outside the screen are culled as well.
+		std::size_t cull_aabbs(const aabb_soa& boxes, std::span<uint32_t> visible, uint32_t first_index = 0) const;
+		bool is_visible(const vec3f& center, const vec3f& extent) const;
+
+		uint32_t get_width() const;
+		uint32_t get_height() const;
+		// rows top to bottom, 1 where nothing has been drawn
+		std::span<const float> get_depth() const;
+
+	private:
+		uint32_t _width;
+		uint32_t _height;
+		uint32_t _tiles_x;
+		uint32_t _tiles_y;
+		mat4f _view_proj;
+		bool _finalized;
+
+		std::vector<float> _depth;
+		// farthest depth of every tile
+		std::vector<float> _tile_depth;
+
+		// screen bounds and nearest depth of four projected boxes
+		struct screen_rects
+		{
+			float min_x[4], min_y[4], max_x[4], max_y[4];
+			float nearest[4];
+			int crosses_near;
+		};
+
+		screen_rects project_boxes(simd::float4 center_x, simd::float4 center_y, simd::float4 center_z,
+			simd::float4 extent_x, simd::float4 extent_y, simd::float4 extent_z) const;
+		bool test_rect(const screen_rects& rects, int lane) const;
+		void rasterize_triangle(const vec4f& v0, const vec4f& v1, const vec4f& v2);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "quat.hpp"
+
+#include <cmath>
+#include "simd.hpp"
+
+namespace quat {
+	quatf from_axis_angle(const vec3f& axis, float angle_in_rad)
+	{
+		const float half_angle = angle_in_rad * 0.5f;
+		const float sin = std::sin(half_angle);
+		return quatf(axis.x * sin, axis.y * sin, axis.z * sin, std::cos(half_angle));
+	}
+
+	quatf normalize(const quatf& q)
+	{
+		const float inv_length = 1.0f / std::sqrt(dot(q, q));
+		return quatf(q.x * inv_length, q.y * inv_length, q.z * inv_length, q.w * inv_length);
+	}
+
+	void normalize(std::span<quatf> quats)
+	{
+		std::size_t i = 0;
+
+#if defined(SIMD_SSE2)
+		// transpose four quaternions so every register holds one component of all four
+		for (; i + 4 <= quats.size(); i += 4)
+		{
+			__m128 x = _mm_load_ps(quats[i + 0].data);
+			__m128 y = _mm_load_ps(quats[i + 1].data);
+			__m128 z = _mm_load_ps(quats[i + 2].data);
+			__m128 w = _mm_load_ps(quats[i + 3].data);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+
+			const __m128 length_sq = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+				_mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+			const __m128 inv_length = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length_sq));
+
+			x = _mm_mul_ps(x, inv_length);
+			y = _mm_mul_ps(y, inv_length);
+			z = _mm_mul_ps(z, inv_length);
+			w = _mm_mul_ps(w, inv_length);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+
+			_mm_store_ps(quats[i + 0].data, x);
+			_mm_store_ps(quats[i + 1].data, y);
+			_mm_store_ps(quats[i + 2].data, z);
+			_mm_store_ps(quats[i + 3].data, w);
+		}
+#endif
+
+		for (; i < quats.size(); ++i)
+		{
+			quats[i] = normalize(quats[i]);
+		}
+	}
+
+	quatf nlerp(const quatf& a, const quatf& b, float t)
+	{
+		// q and -q are the same rotation, flip b onto the hemisphere of a to take the short way
+		const float sign = dot(a, b) < 0.0f ? -1.0f : 1.0f;
+		const float s = 1.0f - t;
+		const float u = t * sign;
+		return normalize(quatf(a.x * s + b.x * u, a.y * s + b.y * u, a.z * s + b.z * u, a.w * s + b.w * u));
+	}
+
+	quatf slerp(const quatf& a, const quatf& b, float t)
+	{
+		float cos_angle = dot(a, b);
+		float sign = 1.0f;
+		if (cos_angle < 0.0f)
+		{
+			cos_angle = -cos_angle;
+			sign = -1.0f;
+		}
+
+		// nearly identical rotations, sin(angle) would be close to zero
+		if (cos_angle > 0.9995f)
+		{
+			return nlerp(a, b, t);
+		}
+
+		const float angle = std::acos(cos_angle);
+		const float inv_sin = 1.0f / std::sin(angle);
+		const float s = std::sin((1.0f - t) * angle) * inv_sin;
+		const float u = std::sin(t * angle) * inv_sin * sign;
+		return quatf(a.x * s + b.x * u, a.y * s + b.y * u, a.z * s + b.z * u, a.w * s + b.w * u);
+	}
+
+	vec3f rotate(const quatf& q, const vec3f& v)
+	{
+		// v' = v + 2w (u x v) + 2 u x (u x v)
+		const vec3f u(q.x, q.y, q.z);
+		const vec3f t = vec::cross(u, v) * 2.0f;
+		return v + t * q.w + vec::cross(u, t);
+	}
+}
\ No newline at end of file
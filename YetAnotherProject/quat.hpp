@@ -0,0 +1,74 @@
+#ifndef QUAT_INCLUDED
+#define QUAT_INCLUDED
+
+#pragma once
+
+#include <span>
+#include "vec.hpp"
+
+// Rotation quaternion, x, y, z hold the imaginary (axis) part and w the real part.
+// Default constructed it is the identity rotation.
+union alignas(16) quatf
+{
+	float data[4];
+	struct { float x, y, z, w; };
+
+	constexpr quatf()
+		: x(0.0f), y(0.0f), z(0.0f), w(1.0f)
+	{
+	}
+
+	constexpr quatf(float _x, float _y, float _z, float _w)
+		: x(_x), y(_y), z(_z), w(_w)
+	{
+	}
+};
+
+namespace quat {
+	constexpr quatf identity()
+	{
+		return quatf();
+	}
+
+	// a * b applies b first, then a
+	constexpr quatf multiply(const quatf& a, const quatf& b)
+	{
+		return quatf(
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+	}
+
+	constexpr quatf conjugate(const quatf& q)
+	{
+		return quatf(-q.x, -q.y, -q.z, q.w);
+	}
+
+	constexpr float dot(const quatf& a, const quatf& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	}
+
+	// axis has to be normalized
+	quatf from_axis_angle(const vec3f& axis, float angle_in_rad);
+	quatf normalize(const quatf& q);
+	// normalizes all quaternions in place, four at a time with sse
+	void normalize(std::span<quatf> quats);
+
+	// Normalized linear interpolation, takes the shortest path. Cheap and good enough for small steps,
+	// e.g. between two fixed simulation steps.
+	quatf nlerp(const quatf& a, const quatf& b, float t);
+	// Spherical linear interpolation with constant angular velocity, takes the shortest path.
+	quatf slerp(const quatf& a, const quatf& b, float t);
+
+	// rotates v by the unit quaternion q
+	vec3f rotate(const quatf& q, const vec3f& v);
+}
+
+constexpr quatf operator * (const quatf& lhs, const quatf& rhs)
+{
+	return quat::multiply(lhs, rhs);
+}
+
+#endif
\ No newline at end of file
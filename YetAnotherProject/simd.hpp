@@ -0,0 +1,141 @@
+#ifndef SIMD_INCLUDED
+#define SIMD_INCLUDED
+
+#pragma once
+
+// Compile time selection of the instruction sets used by the math kernels.
+// SSE2 is always available on x64, AVX2 only when compiling with /arch:AVX2 (or -mavx2).
+// Define SIMD_DISABLE to force the scalar fallbacks, e.g. to compare results.
+#if !defined(SIMD_DISABLE)
+	#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define SIMD_SSE2 1
+	#endif
+
+	#if defined(SIMD_SSE2) && defined(__AVX2__)
+		#define SIMD_AVX2 1
+	#endif
+#endif
+
+#if defined(SIMD_AVX2)
+	#include <immintrin.h>
+#elif defined(SIMD_SSE2)
+	#include <emmintrin.h>
+#endif
+
+#include <cmath>
+#include <cstring>
+
+namespace simd {
+	// Four floats processed at once. Used by the structure of arrays kernels (culling, collision, ...)
+	// so they only have to be written once, with a plain array fallback without sse.
+	// Comparisons return lane masks (all bits set / cleared), which can be used with select / mask_bits.
+	struct float4
+	{
+#if defined(SIMD_SSE2)
+		__m128 v;
+#else
+		float v[4];
+#endif
+	};
+
+#if defined(SIMD_SSE2)
+	inline float4 set1(float f) { return { _mm_set1_ps(f) }; }
+	inline float4 set(float x, float y, float z, float w) { return { _mm_setr_ps(x, y, z, w) }; }
+	inline float4 load(const float* p) { return { _mm_loadu_ps(p) }; }
+	inline void store(float* p, float4 a) { _mm_storeu_ps(p, a.v); }
+
+	inline float4 operator + (float4 a, float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline float4 operator - (float4 a, float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline float4 operator * (float4 a, float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline float4 operator / (float4 a, float4 b) { return { _mm_div_ps(a.v, b.v) }; }
+	inline float4 operator - (float4 a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+	inline float4 min(float4 a, float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+	inline float4 max(float4 a, float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+	inline float4 sqrt(float4 a) { return { _mm_sqrt_ps(a.v) }; }
+	inline float4 abs(float4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+
+	inline float4 operator < (float4 a, float4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+	inline float4 operator <= (float4 a, float4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+	inline float4 operator > (float4 a, float4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+	inline float4 operator >= (float4 a, float4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+	inline float4 operator & (float4 a, float4 b) { return { _mm_and_ps(a.v, b.v) }; }
+	inline float4 operator | (float4 a, float4 b) { return { _mm_or_ps(a.v, b.v) }; }
+	// mask ? a : b
+	inline float4 select(float4 mask, float4 a, float4 b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+	// one bit per lane, bit i is set when lane i of the mask is set
+	inline int mask_bits(float4 mask) { return _mm_movemask_ps(mask.v); }
+#else
+	namespace detail {
+		template <typename Op>
+		inline float4 apply(float4 a, float4 b, Op op)
+		{
+			float4 r;
+			for (int i = 0; i < 4; ++i)
+				r.v[i] = op(a.v[i], b.v[i]);
+			return r;
+		}
+
+		inline float mask_value(bool b)
+		{
+			const unsigned int bits = b ? 0xFFFFFFFFu : 0u;
+			float f;
+			std::memcpy(&f, &bits, sizeof(f));
+			return f;
+		}
+
+		inline unsigned int bits_of(float f)
+		{
+			unsigned int bits;
+			std::memcpy(&bits, &f, sizeof(bits));
+			return bits;
+		}
+
+		inline float from_bits(unsigned int bits)
+		{
+			float f;
+			std::memcpy(&f, &bits, sizeof(f));
+			return f;
+		}
+	}
+
+	inline float4 set1(float f) { return { { f, f, f, f } }; }
+	inline float4 set(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+	inline float4 load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	inline void store(float* p, float4 a) { for (int i = 0; i < 4; ++i) p[i] = a.v[i]; }
+
+	inline float4 operator + (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return x + y; }); }
+	inline float4 operator - (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return x - y; }); }
+	inline float4 operator * (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return x * y; }); }
+	inline float4 operator / (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return x / y; }); }
+	inline float4 operator - (float4 a) { return { { -a.v[0], -a.v[1], -a.v[2], -a.v[3] } }; }
+	inline float4 min(float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return x < y ? x : y; }); }
+	inline float4 max(float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return x > y ? x : y; }); }
+	inline float4 sqrt(float4 a) { return { { std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3]) } }; }
+	inline float4 abs(float4 a) { return { { std::fabs(a.v[0]), std::fabs(a.v[1]), std::fabs(a.v[2]), std::fabs(a.v[3]) } }; }
+
+	inline float4 operator < (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return detail::mask_value(x < y); }); }
+	inline float4 operator <= (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return detail::mask_value(x <= y); }); }
+	inline float4 operator > (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return detail::mask_value(x > y); }); }
+	inline float4 operator >= (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return detail::mask_value(x >= y); }); }
+	inline float4 operator & (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return detail::from_bits(detail::bits_of(x) & detail::bits_of(y)); }); }
+	inline float4 operator | (float4 a, float4 b) { return detail::apply(a, b, [](float x, float y) { return detail::from_bits(detail::bits_of(x) | detail::bits_of(y)); }); }
+
+	inline float4 select(float4 mask, float4 a, float4 b)
+	{
+		float4 r;
+		for (int i = 0; i < 4; ++i)
+			r.v[i] = detail::bits_of(mask.v[i]) ? a.v[i] : b.v[i];
+		return r;
+	}
+
+	inline int mask_bits(float4 mask)
+	{
+		int bits = 0;
+		for (int i = 0; i < 4; ++i)
+			bits |= (detail::bits_of(mask.v[i]) >> 31) << i;
+		return bits;
+	}
+#endif
+}
+
+#endif
\ No newline at end of file
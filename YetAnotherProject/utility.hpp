@@ -8,8 +8,21 @@ namespace util
 	{
 		float cot(float rad);
 
-		float pi();
-		float pi2();
-		float pi4();
+		inline constexpr float pi_value = 3.14159265358979323846f;
+
+		constexpr float pi()
+		{
+			return pi_value;
+		}
+
+		constexpr float pi2()
+		{
+			return pi_value / 2.0f;
+		}
+
+		constexpr float pi4()
+		{
+			return pi_value / 4.0f;
+		}
 	}
 }
\ No newline at end of file
@@ -3,10 +3,16 @@
 
 #pragma once
 
+#include <type_traits>
+#include "simd.hpp"
+
 template <typename Type, unsigned int Dimension>
 union vec_type
 {
 	Type data[Dimension];
+
+	constexpr Type& operator [] (unsigned int i) { return data[i]; }
+	constexpr const Type& operator [] (unsigned int i) const { return data[i]; }
 };
 
 template <typename T>
@@ -15,20 +21,35 @@ union vec_type<T, 2>
 	T data[2];
 	struct { T x, y; };
 
-	vec_type()
+	constexpr vec_type()
 		: x(T()), y(T())
 	{
 	}
 
-	vec_type(const vec_type& rhs)
+	constexpr vec_type(const vec_type& rhs)
 		: x(rhs.x), y(rhs.y)
 	{
 	}
 
-	vec_type(T _x, T _y)
+	constexpr vec_type(T _x, T _y)
 		: x(_x), y(_y)
 	{
 	}
+
+	// named members are used during constant evaluation, where reading the inactive data member is not allowed
+	constexpr T& operator [] (unsigned int i)
+	{
+		if (std::is_constant_evaluated())
+			return i == 0 ? x : y;
+		return data[i];
+	}
+
+	constexpr const T& operator [] (unsigned int i) const
+	{
+		if (std::is_constant_evaluated())
+			return i == 0 ? x : y;
+		return data[i];
+	}
 };
 
 template <typename T>
@@ -37,20 +58,34 @@ union vec_type<T, 3>
 	T data[3];
 	struct { T x, y, z; };
 
-	vec_type()
+	constexpr vec_type()
 		: x(T()), y(T()), z(T())
 	{
 	}
 
-	vec_type(const vec_type& rhs)
+	constexpr vec_type(const vec_type& rhs)
 		: x(rhs.x), y(rhs.y), z(rhs.z)
 	{
 	}
 
-	vec_type(T _x, T _y, T _z)
+	constexpr vec_type(T _x, T _y, T _z)
 		: x(_x), y(_y), z(_z)
 	{
 	}
+
+	constexpr T& operator [] (unsigned int i)
+	{
+		if (std::is_constant_evaluated())
+			return i == 0 ? x : (i == 1 ? y : z);
+		return data[i];
+	}
+
+	constexpr const T& operator [] (unsigned int i) const
+	{
+		if (std::is_constant_evaluated())
+			return i == 0 ? x : (i == 1 ? y : z);
+		return data[i];
+	}
 };
 
 template <typename T>
@@ -59,29 +94,91 @@ union vec_type<T, 4>
 	T data[4];
 	struct { T x, y, z, w; };
 
-	vec_type()
+	constexpr vec_type()
 		: x(T()), y(T()), z(T()), w(T())
 	{
 	}
 
-	vec_type(const vec_type& rhs)
+	constexpr vec_type(const vec_type& rhs)
 		: x(rhs.x), y(rhs.y), z(rhs.z), w(rhs.w)
 	{
 	}
 
-	vec_type(T _x, T _y, T _z, T _w)
+	constexpr vec_type(T _x, T _y, T _z, T _w)
 		: x(_x), y(_y), z(_z), w(_w)
 	{
 	}
+
+	constexpr T& operator [] (unsigned int i)
+	{
+		if (std::is_constant_evaluated())
+			return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w));
+		return data[i];
+	}
+
+	constexpr const T& operator [] (unsigned int i) const
+	{
+		if (std::is_constant_evaluated())
+			return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w));
+		return data[i];
+	}
+};
+
+// float4 is the work horse of the mat4f math and gets an aligned specialization,
+// which allows loading it straight into a SSE register.
+template <>
+union alignas(16) vec_type<float, 4>
+{
+	float data[4];
+	struct { float x, y, z, w; };
+#if defined(SIMD_SSE2)
+	__m128 simd;
+#endif
+
+	constexpr vec_type()
+		: x(0.0f), y(0.0f), z(0.0f), w(0.0f)
+	{
+	}
+
+	constexpr vec_type(const vec_type& rhs)
+		: x(rhs.x), y(rhs.y), z(rhs.z), w(rhs.w)
+	{
+	}
+
+	constexpr vec_type(float _x, float _y, float _z, float _w)
+		: x(_x), y(_y), z(_z), w(_w)
+	{
+	}
+
+	constexpr float& operator [] (unsigned int i)
+	{
+		if (std::is_constant_evaluated())
+			return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w));
+		return data[i];
+	}
+
+	constexpr const float& operator [] (unsigned int i) const
+	{
+		if (std::is_constant_evaluated())
+			return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w));
+		return data[i];
+	}
+
+#if defined(SIMD_SSE2)
+	explicit vec_type(__m128 v)
+		: simd(v)
+	{
+	}
+#endif
 };
 
 namespace vec {
 	template <typename Type, unsigned int Dimension>
-	float length_sq(const vec_type<Type, Dimension>& v)
+	constexpr float length_sq(const vec_type<Type, Dimension>& v)
 	{
 		Type result = 0;
 		for (unsigned int i = 0; i < Dimension; ++i)
-			result += v.data[i] * v.data[i];
+			result += v[i] * v[i];
 		return result;
 	}
 
@@ -98,30 +195,30 @@ namespace vec {
 		vec_type<Type, Dimension> result = v;
 		float l = length(v);
 		for (unsigned int i = 0; i < Dimension; ++i)
-			result.data[i] /= l;
+			result[i] /= l;
 		return result;
 	}
 
 	template <typename Type, unsigned int Dimension>
-	Type dot(const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
+	constexpr Type dot(const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
 	{
 		Type result = 0;
 		for (unsigned int i = 0; i < Dimension; ++i)
-			result += a.data[i] * b.data[i];
+			result += a[i] * b[i];
 		return result;
 	}
 
 	// vec2
 
 	template <typename Type>
-	Type cross(const vec_type<Type, 2>& a, const vec_type<Type, 2>& b)
+	constexpr Type cross(const vec_type<Type, 2>& a, const vec_type<Type, 2>& b)
 	{
 		return a.x * b.y - a.y * b.x;
 	}
 
 	// vec3
 	template <typename Type>
-	vec_type<Type, 3> cross(const vec_type<Type, 3>& a, const vec_type<Type, 3>& b)
+	constexpr vec_type<Type, 3> cross(const vec_type<Type, 3>& a, const vec_type<Type, 3>& b)
 	{
 		vec_type<Type, 3> result;
 		result.x = a.y * b.z - a.z * b.y;
@@ -132,86 +229,114 @@ namespace vec {
 }
 
 template <typename Type, unsigned int Dimension>
-vec_type<Type, Dimension>& operator += (vec_type<Type, Dimension>& lhs, const vec_type<Type, Dimension>& rhs)
+constexpr vec_type<Type, Dimension>& operator += (vec_type<Type, Dimension>& lhs, const vec_type<Type, Dimension>& rhs)
 {
 	for (unsigned int i = 0; i < Dimension; ++i)
-		lhs.data[i] = lhs.data[i] + rhs.data[i];
+		lhs[i] = lhs[i] + rhs[i];
 	return lhs;
 }
 
 template <typename Type, unsigned int Dimension>
-vec_type<Type, Dimension>& operator -= (vec_type<Type, Dimension>& lhs, const vec_type<Type, Dimension>& rhs)
+constexpr vec_type<Type, Dimension>& operator -= (vec_type<Type, Dimension>& lhs, const vec_type<Type, Dimension>& rhs)
 {
 	for (unsigned int i = 0; i < Dimension; ++i)
-		lhs.data[i] = lhs.data[i] - rhs.data[i];
+		lhs[i] = lhs[i] - rhs[i];
 	return lhs;
 }
 
 template <typename Type, unsigned int Dimension>
-vec_type<Type, Dimension>& operator *= (vec_type<Type, Dimension>& lhs, const float rhs)
+constexpr vec_type<Type, Dimension>& operator *= (vec_type<Type, Dimension>& lhs, const float rhs)
 {
 	for (unsigned int i = 0; i < Dimension; ++i)
-		lhs.data[i] = lhs.data[i] * rhs;
+		lhs[i] = lhs[i] * rhs;
 	return lhs;
 }
 
 template <typename Type, unsigned int Dimension>
-bool operator == (const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
+constexpr bool operator == (const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
 {
 	for (unsigned int i = 0; i < Dimension; ++i)
-		if (a.data[i] != b.data[i])
+		if (a[i] != b[i])
 			return false;
 	return true;
 }
 
 template <typename Type, unsigned int Dimension>
-bool operator != (const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
+constexpr bool operator != (const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
 {
 	return !(a == b);
 }
 
 template <typename Type, unsigned int Dimension>
-vec_type<Type, Dimension> operator + (const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
+constexpr vec_type<Type, Dimension> operator + (const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
 {
 	vec_type<Type, Dimension> c;
 	for (unsigned int i = 0; i < Dimension; ++i)
-		c.data[i] = a.data[i] + b.data[i];
+		c[i] = a[i] + b[i];
 	return c;
 }
 
 template <typename Type, unsigned int Dimension>
-vec_type<Type, Dimension> operator - (const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
+constexpr vec_type<Type, Dimension> operator - (const vec_type<Type, Dimension>& a, const vec_type<Type, Dimension>& b)
 {
 	vec_type<Type, Dimension> c;
 	for (unsigned int i = 0; i < Dimension; ++i)
-		c.data[i] = a.data[i] - b.data[i];
+		c[i] = a[i] - b[i];
 	return c;
 }
 
 template <typename Type, unsigned int Dimension>
-vec_type<Type, Dimension> operator - (const vec_type<Type, Dimension>& a)
+constexpr vec_type<Type, Dimension> operator - (const vec_type<Type, Dimension>& a)
 {
 	vec_type<Type, Dimension> c;
 	for (unsigned int i = 0; i < Dimension; ++i)
-		c.data[i] = -a.data[i];
+		c[i] = -a[i];
 	return c;
 }
 
 template <typename Type, unsigned int Dimension>
-vec_type<Type, Dimension> operator * (const vec_type<Type, Dimension>& v, float f)
+constexpr vec_type<Type, Dimension> operator * (const vec_type<Type, Dimension>& v, float f)
 {
 	vec_type<Type, Dimension> c;
 	for (unsigned int i = 0; i < Dimension; ++i)
-		c.data[i] = v.data[i] * f;
+		c[i] = v[i] * f;
 	return c;
 }
 
 template <typename Type, unsigned int Dimension>
-vec_type<Type, Dimension> operator * (float f, const vec_type<Type, Dimension>& v)
+constexpr vec_type<Type, Dimension> operator * (float f, const vec_type<Type, Dimension>& v)
 {
 	return v * f;
 }
 
+// vec4f operators use sse at runtime and fall back to scalar code during constant evaluation
+constexpr vec_type<float, 4> operator + (const vec_type<float, 4>& a, const vec_type<float, 4>& b)
+{
+#if defined(SIMD_SSE2)
+	if (!std::is_constant_evaluated())
+		return vec_type<float, 4>(_mm_add_ps(_mm_load_ps(a.data), _mm_load_ps(b.data)));
+#endif
+	return vec_type<float, 4>(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+}
+
+constexpr vec_type<float, 4> operator - (const vec_type<float, 4>& a, const vec_type<float, 4>& b)
+{
+#if defined(SIMD_SSE2)
+	if (!std::is_constant_evaluated())
+		return vec_type<float, 4>(_mm_sub_ps(_mm_load_ps(a.data), _mm_load_ps(b.data)));
+#endif
+	return vec_type<float, 4>(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+}
+
+constexpr vec_type<float, 4> operator * (const vec_type<float, 4>& v, float f)
+{
+#if defined(SIMD_SSE2)
+	if (!std::is_constant_evaluated())
+		return vec_type<float, 4>(_mm_mul_ps(_mm_load_ps(v.data), _mm_set1_ps(f)));
+#endif
+	return vec_type<float, 4>(v.x * f, v.y * f, v.z * f, v.w * f);
+}
+
 typedef vec_type<float, 2> vec2f;
 typedef vec_type<double, 2> vec2d;
 
@@ -12,7 +12,6 @@
 cbuffer BasicConstBuffer : register(b0)
 {
     float4x4 mvp;
-    float4x4 dx_mvp;
 };
 
 struct PSInput